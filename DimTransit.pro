@@ -1,5 +1,6 @@
 QT       += core gui
 QT       +=sql
+QT       +=concurrent
 QT       +=axcontainer
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -0,0 +1,355 @@
+﻿#include "binarylog.h"
+#include <QtEndian>
+#include <algorithm>
+
+// 三个文件的头：4字节标识 + u16版本
+static const char DATA_MAGIC[] = "DLOG";
+static const char STRING_MAGIC[] = "DSTR";
+static const char INDEX_MAGIC[] = "DIDX";
+static const int HEADER_SIZE = 6;
+// 单条记录的长度上限，超过视为文件损坏
+static const quint32 MAX_RECORD_BYTES = 16 * 1024 * 1024;
+
+static void putU8(QByteArray& buffer, quint8 value)
+{
+    buffer.append(char(value));
+}
+
+static void putU16(QByteArray& buffer, quint16 value)
+{
+    uchar raw[2];
+    qToLittleEndian(value, raw);
+    buffer.append(reinterpret_cast<const char*>(raw), 2);
+}
+
+static void putU32(QByteArray& buffer, quint32 value)
+{
+    uchar raw[4];
+    qToLittleEndian(value, raw);
+    buffer.append(reinterpret_cast<const char*>(raw), 4);
+}
+
+static void putI64(QByteArray& buffer, qint64 value)
+{
+    uchar raw[8];
+    qToLittleEndian(value, raw);
+    buffer.append(reinterpret_cast<const char*>(raw), 8);
+}
+
+static void putString(QByteArray& buffer, const QString& text)
+{
+    const QByteArray utf8 = text.toUtf8();
+    putU32(buffer, quint32(utf8.size()));
+    buffer.append(utf8);
+}
+
+static QByteArray fileHeader(const char* magic)
+{
+    QByteArray header(magic, 4);
+    putU16(header, BinaryLog::VERSION);
+    return header;
+}
+
+// 顺序读取缓冲区中的字段，越界时ok置为false
+class FieldReader
+{
+public:
+    explicit FieldReader(const QByteArray& buffer) : m_buffer(buffer) {}
+    bool ok() const { return m_ok; }
+    bool atEnd() const { return m_pos >= m_buffer.size(); }
+    int position() const { return m_pos; }
+
+    quint8 u8() { return require(1) ? quint8(m_buffer.at(m_pos++)) : 0; }
+    quint16 u16() { return read<quint16>(); }
+    quint32 u32() { return read<quint32>(); }
+    qint64 i64() { return read<qint64>(); }
+    QString string()
+    {
+        const quint32 size = u32();
+        if (!m_ok || !require(int(size))) return QString();
+        QString text = QString::fromUtf8(m_buffer.constData() + m_pos, int(size));
+        m_pos += int(size);
+        return text;
+    }
+
+private:
+    template<typename T>
+    T read()
+    {
+        if (!require(sizeof(T))) return T(0);
+        T value = qFromLittleEndian<T>(reinterpret_cast<const uchar*>(m_buffer.constData() + m_pos));
+        m_pos += int(sizeof(T));
+        return value;
+    }
+    bool require(int size)
+    {
+        if (size < 0 || m_pos + size > m_buffer.size()) m_ok = false;
+        return m_ok;
+    }
+
+private:
+    const QByteArray& m_buffer;
+    int m_pos = 0;
+    bool m_ok = true;
+};
+
+static bool checkHeader(const QByteArray& header, const char* magic)
+{
+    if (header.size() < HEADER_SIZE || !header.startsWith(magic)) return false;
+    return qFromLittleEndian<quint16>(reinterpret_cast<const uchar*>(header.constData() + 4)) == BinaryLog::VERSION;
+}
+
+// ===================== BinaryLog =====================
+QString BinaryLog::expand(const QString &pattern, const QStringList &args)
+{
+    if (args.isEmpty()) return pattern;
+    QString result;
+    result.reserve(pattern.size() + args.size() * 8);
+    const int length = pattern.size();
+    for (int i = 0; i < length; ++i) {
+        const QChar ch = pattern.at(i);
+        if (ch == QLatin1Char('%') && i + 1 < length && pattern.at(i + 1).isDigit()) {
+            int index = 0;
+            int end = i + 1;
+            while (end < length && pattern.at(end).isDigit() && index < 100) {
+                index = index * 10 + pattern.at(end).digitValue();
+                ++end;
+            }
+            if (index >= 1 && index <= args.size()) {
+                result += args.at(index - 1);
+                i = end - 1;
+                continue;
+            }
+        }
+        result += ch;
+    }
+    return result;
+}
+
+QString BinaryLog::levelName(int level)
+{
+    static const char* names[] = {"DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+    return level >= 0 && level < 5 ? QString(names[level]) : QString::number(level);
+}
+
+// ===================== BinaryLogWriter =====================
+BinaryLogWriter::~BinaryLogWriter()
+{
+    close();
+}
+
+bool BinaryLogWriter::open(const QString &basePath, QString *errorMsg)
+{
+    close();
+    m_data.setFileName(basePath + BinaryLog::dataSuffix());
+    m_strings.setFileName(basePath + BinaryLog::stringSuffix());
+    m_index.setFileName(basePath + BinaryLog::indexSuffix());
+    for (QFile* file : {&m_data, &m_strings, &m_index}) {
+        if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            if (errorMsg) *errorMsg = QString("%1：%2").arg(file->fileName(), file->errorString());
+            close();
+            return false;
+        }
+    }
+    m_dataBuffer = fileHeader(DATA_MAGIC);
+    m_stringBuffer = fileHeader(STRING_MAGIC);
+    m_indexBuffer = fileHeader(INDEX_MAGIC);
+    m_stringIds.clear();
+    m_dataOffset = HEADER_SIZE;
+    m_sinceIndex = 0;
+    return true;
+}
+
+quint32 BinaryLogWriter::intern(const QString &text)
+{
+    auto it = m_stringIds.constFind(text);
+    if (it != m_stringIds.constEnd()) return it.value();
+    const quint32 id = quint32(m_stringIds.size() + 1);
+    m_stringIds.insert(text, id);
+    putString(m_stringBuffer, text);
+    return id;
+}
+
+void BinaryLogWriter::append(const Entry &entry)
+{
+    if (!isOpen()) return;
+    if (m_sinceIndex == 0) {
+        putI64(m_indexBuffer, entry.timestampMs);
+        putI64(m_indexBuffer, m_dataOffset);
+    }
+    m_sinceIndex = (m_sinceIndex + 1) % BinaryLog::INDEX_INTERVAL;
+
+    // 记录：u32长度 + 时间 + 等级 + 设备/线程/模板编号（模板为0时内联消息）+ 参数
+    QByteArray record;
+    putI64(record, entry.timestampMs);
+    putU8(record, quint8(entry.level));
+    putU32(record, intern(entry.device));
+    putU32(record, intern(entry.threadId));
+    if (entry.args.isEmpty()) {
+        putU32(record, 0);
+        putString(record, entry.message);
+    } else {
+        putU32(record, intern(entry.message));
+    }
+    const int argCount = qMin(entry.args.size(), 255);
+    putU8(record, quint8(argCount));
+    for (int i = 0; i < argCount; ++i) {
+        putString(record, entry.args.at(i));
+    }
+    putU32(m_dataBuffer, quint32(record.size()));
+    m_dataBuffer.append(record);
+    m_dataOffset += 4 + record.size();
+}
+
+void BinaryLogWriter::flush()
+{
+    if (!isOpen()) return;
+    if (!m_stringBuffer.isEmpty()) {
+        m_strings.write(m_stringBuffer);
+        m_strings.flush();
+        m_stringBuffer.clear();
+    }
+    if (!m_dataBuffer.isEmpty()) {
+        m_data.write(m_dataBuffer);
+        m_data.flush();
+        m_dataBuffer.clear();
+    }
+    if (!m_indexBuffer.isEmpty()) {
+        m_index.write(m_indexBuffer);
+        m_index.flush();
+        m_indexBuffer.clear();
+    }
+}
+
+void BinaryLogWriter::close()
+{
+    flush();
+    m_data.close();
+    m_strings.close();
+    m_index.close();
+}
+
+// ===================== BinaryLogReader =====================
+bool BinaryLogReader::open(const QString &dataPath, QString *errorMsg)
+{
+    QString basePath = dataPath;
+    if (basePath.endsWith(BinaryLog::dataSuffix())) {
+        basePath.chop(BinaryLog::dataSuffix().size());
+    }
+    m_data.close();
+    m_strings.clear();
+    m_indexTimes.clear();
+    m_indexOffsets.clear();
+
+    // 字符串表与索引整体读入；末尾不完整的项（写入中途崩溃）忽略
+    QFile strings(basePath + BinaryLog::stringSuffix());
+    if (!strings.open(QIODevice::ReadOnly)) {
+        if (errorMsg) *errorMsg = QString("%1：%2").arg(strings.fileName(), strings.errorString());
+        return false;
+    }
+    const QByteArray stringBytes = strings.readAll();
+    if (!checkHeader(stringBytes, STRING_MAGIC)) {
+        if (errorMsg) *errorMsg = QString("字符串表格式不符：%1").arg(strings.fileName());
+        return false;
+    }
+    FieldReader stringReader(stringBytes);
+    stringReader.u32();
+    stringReader.u16();
+    while (!stringReader.atEnd()) {
+        QString text = stringReader.string();
+        if (!stringReader.ok()) break;
+        m_strings << text;
+    }
+
+    QFile index(basePath + BinaryLog::indexSuffix());
+    if (index.open(QIODevice::ReadOnly)) {
+        const QByteArray indexBytes = index.readAll();
+        if (checkHeader(indexBytes, INDEX_MAGIC)) {
+            FieldReader indexReader(indexBytes);
+            indexReader.u32();
+            indexReader.u16();
+            while (!indexReader.atEnd()) {
+                const qint64 time = indexReader.i64();
+                const qint64 offset = indexReader.i64();
+                if (!indexReader.ok()) break;
+                m_indexTimes << time;
+                m_indexOffsets << offset;
+            }
+        }
+    }
+
+    m_data.setFileName(basePath + BinaryLog::dataSuffix());
+    if (!m_data.open(QIODevice::ReadOnly)) {
+        if (errorMsg) *errorMsg = QString("%1：%2").arg(m_data.fileName(), m_data.errorString());
+        return false;
+    }
+    if (!checkHeader(m_data.read(HEADER_SIZE), DATA_MAGIC)) {
+        if (errorMsg) *errorMsg = QString("日志文件格式不符：%1").arg(m_data.fileName());
+        m_data.close();
+        return false;
+    }
+    return true;
+}
+
+QString BinaryLogReader::stringAt(quint32 id) const
+{
+    return id >= 1 && int(id) <= m_strings.size() ? m_strings.at(int(id) - 1) : QString("?");
+}
+
+qint64 BinaryLogReader::seekOffset(qint64 fromMs) const
+{
+    if (fromMs == std::numeric_limits<qint64>::min()) return HEADER_SIZE;
+    const qint64 target = fromMs - BinaryLog::ORDER_SLACK_MS;
+    auto it = std::lower_bound(m_indexTimes.constBegin(), m_indexTimes.constEnd(), target);
+    if (it == m_indexTimes.constBegin()) return HEADER_SIZE;
+    return m_indexOffsets.at(int(it - m_indexTimes.constBegin()) - 1);
+}
+
+int BinaryLogReader::query(const Filter &filter, const std::function<bool (const Record &)> &callback)
+{
+    if (!m_data.isOpen()) return 0;
+    const qint64 stopMs = filter.toMs > std::numeric_limits<qint64>::max() - BinaryLog::ORDER_SLACK_MS
+            ? filter.toMs : filter.toMs + BinaryLog::ORDER_SLACK_MS;
+    m_data.seek(seekOffset(filter.fromMs));
+    int matched = 0;
+    QByteArray body;
+    while (true) {
+        const QByteArray sizeBytes = m_data.read(4);
+        if (sizeBytes.size() < 4) break;
+        const quint32 size = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(sizeBytes.constData()));
+        if (size > MAX_RECORD_BYTES) break;
+        body = m_data.read(size);
+        if (body.size() < int(size)) break;
+
+        FieldReader reader(body);
+        Record record;
+        record.timestampMs = reader.i64();
+        record.level = reader.u8();
+        if (!reader.ok()) break;
+        if (record.timestampMs > stopMs) break;
+        // 先用定长字段过滤，匹配后再解码消息
+        if (record.timestampMs < filter.fromMs || record.timestampMs > filter.toMs || record.level < filter.minLevel) {
+            continue;
+        }
+        record.device = stringAt(reader.u32());
+        if (!filter.device.isEmpty() && record.device.compare(filter.device, Qt::CaseInsensitive) != 0) {
+            continue;
+        }
+        record.threadId = stringAt(reader.u32());
+        const quint32 templateId = reader.u32();
+        const QString pattern = templateId == 0 ? reader.string() : stringAt(templateId);
+        QStringList args;
+        const int argCount = reader.u8();
+        for (int i = 0; i < argCount && reader.ok(); ++i) {
+            args << reader.string();
+        }
+        if (!reader.ok()) break;
+        record.message = BinaryLog::expand(pattern, args);
+        if (!filter.contains.isEmpty() && !record.message.contains(filter.contains, Qt::CaseInsensitive)) {
+            continue;
+        }
+        ++matched;
+        if (!callback(record)) break;
+    }
+    return matched;
+}
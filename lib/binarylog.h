@@ -0,0 +1,121 @@
+﻿#ifndef BINARYLOG_H
+#define BINARYLOG_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QVector>
+#include <functional>
+#include <limits>
+
+///
+/// \brief 结构化二进制日志
+/// 每个日志由三个文件组成（同名，扩展名不同）：
+///   .dlog 日志记录：时间、等级、设备/线程/模板的字符串编号、参数；
+///   .dstr 字符串表：设备名、线程ID、消息模板按首次出现顺序编号（从1开始）；
+///   .didx 稀疏时间索引：每INDEX_INTERVAL条记录一项（时间戳，记录在.dlog中的偏移）。
+/// 整数均为小端；字符串为u32字节数 + UTF-8。记录按后台线程写出顺序排列，时间戳近似递增。
+/// 只有带参数的模板消息才进入字符串表，普通消息内联保存，避免字符串表无限增长
+///
+class BinaryLog
+{
+public:
+    static constexpr quint16 VERSION = 1;
+    static constexpr int INDEX_INTERVAL = 256;
+    // 时间戳可能轻微乱序，查询时前后放宽的范围
+    static constexpr qint64 ORDER_SLACK_MS = 5000;
+
+    static QString dataSuffix() { return ".dlog"; }
+    static QString stringSuffix() { return ".dstr"; }
+    static QString indexSuffix() { return ".didx"; }
+
+    // 展开%1..%n模板（一次扫描，参数中的%n不会被再次替换）
+    static QString expand(const QString& pattern, const QStringList& args);
+    // 等级名称：DEBUG/INFO/WARN/ERROR/FATAL
+    static QString levelName(int level);
+};
+
+///
+/// \brief 二进制日志写入（非线程安全，由调用方加锁）
+///
+class BinaryLogWriter
+{
+public:
+    struct Entry {
+        qint64 timestampMs = 0;
+        int level = 0;
+        QString device;
+        QString threadId;
+        QString message;     // args非空时为模板
+        QStringList args;
+    };
+
+    ~BinaryLogWriter();
+    // basePath不含扩展名
+    bool open(const QString& basePath, QString* errorMsg = nullptr);
+    bool isOpen() const { return m_data.isOpen(); }
+    // 编码到内存缓冲区
+    void append(const Entry& entry);
+    qint64 bufferedBytes() const { return m_dataBuffer.size() + m_stringBuffer.size() + m_indexBuffer.size(); }
+    // .dlog大小（含未写出的缓冲）
+    qint64 dataBytes() const { return m_dataOffset; }
+    // 缓冲区写入文件：先写字符串表，再写记录，最后写索引，保证读取时引用的字符串已存在
+    void flush();
+    void close();
+
+private:
+    quint32 intern(const QString& text);
+
+private:
+    QFile m_data;
+    QFile m_strings;
+    QFile m_index;
+    QByteArray m_dataBuffer;
+    QByteArray m_stringBuffer;
+    QByteArray m_indexBuffer;
+    QHash<QString, quint32> m_stringIds;
+    qint64 m_dataOffset = 0;    // 下一条记录在.dlog中的偏移（含未写出的缓冲）
+    int m_sinceIndex = 0;
+};
+
+///
+/// \brief 二进制日志查询
+///
+class BinaryLogReader
+{
+public:
+    struct Record {
+        qint64 timestampMs = 0;
+        int level = 0;
+        QString device;
+        QString threadId;
+        QString message;     // 已展开
+    };
+    struct Filter {
+        qint64 fromMs = std::numeric_limits<qint64>::min();
+        qint64 toMs = std::numeric_limits<qint64>::max();
+        int minLevel = 0;
+        QString device;      // 为空不过滤
+        QString contains;    // 消息包含的文本，为空不过滤
+    };
+
+    // dataPath为.dlog文件
+    bool open(const QString& dataPath, QString* errorMsg = nullptr);
+    // 按过滤条件逐条回调，回调返回false时停止；返回匹配条数
+    int query(const Filter& filter, const std::function<bool(const Record&)>& callback);
+
+private:
+    // 查找开始读取的偏移：索引中最后一个早于fromMs（放宽ORDER_SLACK_MS）的位置
+    qint64 seekOffset(qint64 fromMs) const;
+    QString stringAt(quint32 id) const;
+
+private:
+    QFile m_data;
+    QStringList m_strings;
+    QVector<qint64> m_indexTimes;
+    QVector<qint64> m_indexOffsets;
+};
+
+#endif // BINARYLOG_H
@@ -1,4 +1,7 @@
 ﻿#include "iconfig.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDebug>
 
 void BaseMysqlConfig::loadConfig(QSettings *settings)
 {
@@ -10,10 +13,17 @@ void BaseMysqlConfig::loadConfig(QSettings *settings)
     m_username = settings->value("Username", m_username).toString();
     m_password = settings->value("Password", m_password).toString();
     m_dbName = settings->value("DbName", m_dbName).toString();
+    m_readHost = settings->value("ReadHost", m_readHost).toString().trimmed();
+    m_readPort = settings->value("ReadPort", m_readPort).toInt();
+    m_slowQueryMs = settings->value("SlowQueryMs", m_slowQueryMs).toInt();
+    m_queryTimeoutMs = qMax(0, settings->value("QueryTimeoutMs", m_queryTimeoutMs).toInt());
+    m_lockWaitMs = qMax(0, settings->value("LockWaitMs", m_lockWaitMs).toInt());
+    m_readTimeoutSec = qMax(0, settings->value("ReadTimeoutSec", m_readTimeoutSec).toInt());
+    m_driver = normalizeDriver(settings->value("Driver", m_driver).toString());
     settings->endGroup();
 }
 
-void BaseMysqlConfig::saveConfig(QSettings *settings)
+void BaseMysqlConfig::saveConfig(QSettings *settings) const
 {
     if (!settings) return;
     settings->beginGroup(getSection());
@@ -22,13 +32,19 @@ void BaseMysqlConfig::saveConfig(QSettings *settings)
     settings->setValue("Username", m_username);
     settings->setValue("Password", m_password);
     settings->setValue("DbName", m_dbName);
+    settings->setValue("ReadHost", m_readHost);
+    settings->setValue("ReadPort", m_readPort);
+    settings->setValue("SlowQueryMs", m_slowQueryMs);
+    settings->setValue("QueryTimeoutMs", m_queryTimeoutMs);
+    settings->setValue("LockWaitMs", m_lockWaitMs);
+    settings->setValue("ReadTimeoutSec", m_readTimeoutSec);
+    settings->setValue("Driver", m_driver);
     settings->endGroup();
 }
 
 
 void LoginConfig::loadConfig(QSettings *settings)
 {
-    QMutexLocker locker(&m_mutex);
     settings->beginGroup(getSection());
     m_lastAccount = settings->value("LastAccount", "").toString();
     m_lastPwdCipher = settings->value("LastPwdCipher", "").toString(); // 读密文
@@ -36,9 +52,8 @@ void LoginConfig::loadConfig(QSettings *settings)
     settings->endGroup();
 }
 
-void LoginConfig::saveConfig(QSettings *settings)
+void LoginConfig::saveConfig(QSettings *settings) const
 {
-    QMutexLocker locker(&m_mutex);
     settings->beginGroup(getSection());
     settings->setValue("LastAccount", m_lastAccount);
     settings->setValue("LastPwdCipher", m_lastPwdCipher); // 存密文
@@ -46,6 +61,48 @@ void LoginConfig::saveConfig(QSettings *settings)
     settings->endGroup();
 }
 
+void LogConfig::loadConfig(QSettings *settings)
+{
+    settings->beginGroup(getSection());
+    m_queueCapacity = qBound(256, settings->value("QueueCapacity", m_queueCapacity).toInt(), 1 << 20);
+    m_fullPolicy = normalizeFullPolicy(settings->value("FullPolicy", m_fullPolicy).toString());
+    m_fileBufferBytes = qBound(4 * 1024, settings->value("FileBufferBytes", m_fileBufferBytes).toInt(), 16 * 1024 * 1024);
+    m_flushIntervalMs = qBound(50, settings->value("FlushIntervalMs", m_flushIntervalMs).toInt(), 60000);
+    m_maxFileMB = qMax(0, settings->value("MaxFileMB", m_maxFileMB).toInt());
+    m_rotateDaily = settings->value("RotateDaily", m_rotateDaily).toBool();
+    m_maxFiles = qMax(0, settings->value("MaxFiles", m_maxFiles).toInt());
+    m_maxAgeDays = qMax(0, settings->value("MaxAgeDays", m_maxAgeDays).toInt());
+    m_maxTotalMB = qMax(0, settings->value("MaxTotalMB", m_maxTotalMB).toInt());
+    m_compress = settings->value("Compress", m_compress).toBool();
+    m_level = normalizeLevel(settings->value("Level", m_level).toString());
+    m_fileLevel = normalizeLevel(settings->value("FileLevel", m_fileLevel).toString());
+    m_widgetLevel = normalizeLevel(settings->value("WidgetLevel", m_widgetLevel).toString());
+    m_widgetMaxLines = qBound(100, settings->value("WidgetMaxLines", m_widgetMaxLines).toInt(), 1000000);
+    m_structured = settings->value("Structured", m_structured).toBool();
+    settings->endGroup();
+}
+
+void LogConfig::saveConfig(QSettings *settings) const
+{
+    settings->beginGroup(getSection());
+    settings->setValue("QueueCapacity", m_queueCapacity);
+    settings->setValue("FullPolicy", m_fullPolicy);
+    settings->setValue("FileBufferBytes", m_fileBufferBytes);
+    settings->setValue("FlushIntervalMs", m_flushIntervalMs);
+    settings->setValue("MaxFileMB", m_maxFileMB);
+    settings->setValue("RotateDaily", m_rotateDaily);
+    settings->setValue("MaxFiles", m_maxFiles);
+    settings->setValue("MaxAgeDays", m_maxAgeDays);
+    settings->setValue("MaxTotalMB", m_maxTotalMB);
+    settings->setValue("Compress", m_compress);
+    settings->setValue("Level", m_level);
+    settings->setValue("FileLevel", m_fileLevel);
+    settings->setValue("WidgetLevel", m_widgetLevel);
+    settings->setValue("WidgetMaxLines", m_widgetMaxLines);
+    settings->setValue("Structured", m_structured);
+    settings->endGroup();
+}
+
 QString LoginConfig::encrypt(const QString& plainText, const QString& key)
 {
     if (plainText.isEmpty()) return "";
@@ -73,3 +130,258 @@ QString LoginConfig::decrypt(const QString &cipherText, const QString &key)
     return QString::fromUtf8(decryptData);
 
 }
+
+
+// 修改后等待该时间没有新修改再写入；持续修改时最迟SAVE_MAX_DELAY_MS写入一次
+static const int SAVE_DEBOUNCE_MS = 500;
+static const int SAVE_MAX_DELAY_MS = 5000;
+// 写入失败后的重试间隔
+static const int SAVE_RETRY_MS = 5000;
+
+ConfigManager::ConfigManager()
+{
+    m_iniPath=QCoreApplication::applicationDirPath()+"/config.ini";
+    {
+        QSettings settings(m_iniPath,QSettings::IniFormat);
+        settings.setIniCodec("UTF-8");
+        //加载设备
+        registerConfig<MysqlConfig>(settings);
+        //
+        registerConfig<LoginConfig>(settings);
+        registerConfig<LogConfig>(settings);
+        QMutexLocker locker(&m_fileMutex);
+        rememberSectionsLocked(settings);
+    }
+
+    // 监视config.ini：编辑器保存时可能连续触发多次，合并后再重新加载
+    m_reloadTimer = new QTimer(this);
+    m_reloadTimer->setSingleShot(true);
+    m_reloadTimer->setInterval(300);
+    connect(m_reloadTimer, &QTimer::timeout, this, [this]() { reload(); });
+    m_watcher = new QFileSystemWatcher(this);
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, m_reloadTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    watchFile();
+
+    m_saveTimer = new QTimer(this);
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(SAVE_DEBOUNCE_MS);
+    connect(m_saveTimer, &QTimer::timeout, this, &ConfigManager::startSave);
+}
+
+ConfigManager::~ConfigManager()
+{
+    // 退出前写入尚未保存的修改
+    flush();
+}
+
+void ConfigManager::requestSave()
+{
+    QMetaObject::invokeMethod(this, [this]() {
+        if (!m_dirtySince.isValid()) m_dirtySince.start();
+        if (m_dirtySince.elapsed() >= SAVE_MAX_DELAY_MS) {
+            m_saveTimer->stop();
+            startSave();
+        } else {
+            m_saveTimer->start();
+        }
+    }, Qt::QueuedConnection);
+}
+
+void ConfigManager::startSave()
+{
+    if (m_saveThread) {
+        // 上一次写入未结束：结束后再写
+        m_savePending = true;
+        return;
+    }
+    m_dirtySince.invalidate();
+    unsigned taken = 0;
+    QList<std::shared_ptr<const IConfig>> configs = takeDirty(&taken);
+    if (configs.isEmpty()) return;
+    std::shared_ptr<QString> error = std::make_shared<QString>();
+    std::shared_ptr<bool> saved = std::make_shared<bool>(false);
+    QThread *thread = QThread::create([this, configs, error, saved]() { *saved = writeSections(configs, error.get()); });
+    m_saveThread = thread;
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    connect(thread, &QThread::finished, this, [this, thread, taken, error, saved]() {
+        // deleteLater尚未执行，先清除指针，否则重试会被当作写入仍在进行
+        if (m_saveThread == thread) m_saveThread = nullptr;
+        if (!*saved) {
+            // 写入失败：恢复待保存标记，稍后重试
+            restoreDirty(taken);
+            emit saveFailed(*error);
+            QTimer::singleShot(SAVE_RETRY_MS, this, &ConfigManager::startSave);
+            return;
+        }
+        if (m_savePending) {
+            m_savePending = false;
+            startSave();
+        }
+    });
+    m_saveThread->start();
+}
+
+bool ConfigManager::flush(QString *errorMsg)
+{
+    if (m_saveThread) {
+        m_saveThread->wait();
+    }
+    unsigned taken = 0;
+    if (!writeSections(takeDirty(&taken), errorMsg)) {
+        restoreDirty(taken);
+        return false;
+    }
+    return true;
+}
+
+QList<std::shared_ptr<const IConfig>> ConfigManager::takeDirty(unsigned *taken)
+{
+    QList<std::shared_ptr<const IConfig>> configs;
+    QMutexLocker locker(&m_writeMutex);
+    for (int index = 0; index < CONFIG_COUNT; ++index) {
+        if (m_dirty & (1u << index)) {
+            configs << std::atomic_load(&m_configs[index]);
+        }
+    }
+    *taken = m_dirty;
+    m_dirty = 0;
+    return configs;
+}
+
+void ConfigManager::restoreDirty(unsigned taken)
+{
+    QMutexLocker locker(&m_writeMutex);
+    m_dirty |= taken;
+}
+
+bool ConfigManager::writeSections(const QList<std::shared_ptr<const IConfig>> &configs, QString *errorMsg)
+{
+    if (configs.isEmpty()) return true;
+    QMutexLocker locker(&m_fileMutex);
+    // 在临时副本上改写待保存的配置节，其余节与注释外的内容保持原样
+    const QString tmpPath = m_iniPath + ".tmp";
+    QFile::remove(tmpPath);
+    if (QFile::exists(m_iniPath) && !QFile::copy(m_iniPath, tmpPath)) {
+        const QString error = QString("无法创建临时文件%1").arg(tmpPath);
+        qWarning() << "保存配置失败：" << error;
+        if (errorMsg) *errorMsg = error;
+        return false;
+    }
+    {
+        QSettings settings(tmpPath, QSettings::IniFormat);
+        settings.setIniCodec("UTF-8");
+        for (const std::shared_ptr<const IConfig>& config : configs) {
+            config->saveConfig(&settings);
+        }
+        settings.sync();
+        if (settings.status() != QSettings::NoError) {
+            const QString error = QString("写入临时文件%1出错").arg(tmpPath);
+            QFile::remove(tmpPath);
+            qWarning() << "保存配置失败：" << error;
+            if (errorMsg) *errorMsg = error;
+            return false;
+        }
+        // 自身写入引起的文件变化不应被当作外部修改
+        rememberSectionsLocked(settings);
+    }
+    QFile tmpFile(tmpPath);
+    if (!tmpFile.open(QIODevice::ReadOnly)) {
+        const QString error = QString("无法读取临时文件%1").arg(tmpPath);
+        qWarning() << "保存配置失败：" << error;
+        if (errorMsg) *errorMsg = error;
+        return false;
+    }
+    const QByteArray content = tmpFile.readAll();
+    tmpFile.close();
+    QFile::remove(tmpPath);
+    // QSaveFile先写同目录临时文件，commit时整体替换：中途崩溃只会留下旧文件
+    QSaveFile file(m_iniPath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size() || !file.commit()) {
+        const QString error = file.errorString();
+        qWarning() << "保存配置失败：" << error;
+        if (errorMsg) *errorMsg = error;
+        return false;
+    }
+    return true;
+}
+
+QStringList ConfigManager::reload()
+{
+    QStringList changedSections;
+    QList<int> changed;
+    {
+        QMutexLocker fileLocker(&m_fileMutex);
+        watchFile();
+        QSettings settings(m_iniPath, QSettings::IniFormat);
+        settings.setIniCodec("UTF-8");
+        const QStringList groups = settings.childGroups();
+        if (settings.status() != QSettings::NoError) {
+            qWarning() << "config.ini解析失败，保留当前配置";
+            return changedSections;
+        }
+        for (int index = 0; index < CONFIG_COUNT; ++index) {
+            const QString& section = m_sections[index];
+            // 文件正在被改写或删掉了整节：保留当前配置，不退回默认值
+            if (!groups.contains(section)) continue;
+            QVariantMap values = readSection(settings, section);
+            if (values == m_sectionValues.value(section)) continue;
+            // 内容变化：按新文件重新构建该节的配置
+            std::shared_ptr<IConfig> config = m_factories[index]();
+            config->loadConfig(&settings);
+            {
+                QMutexLocker locker(&m_writeMutex);
+                std::atomic_store(&m_configs[index], std::shared_ptr<const IConfig>(config));
+            }
+            m_sectionValues.insert(section, values);
+            changed << index;
+            changedSections << section;
+        }
+    }
+    for (int index : changed) {
+        notifyChanged(index);
+    }
+    return changedSections;
+}
+
+void ConfigManager::rememberSectionsLocked(QSettings &settings)
+{
+    for (const QString& section : m_sections) {
+        m_sectionValues.insert(section, readSection(settings, section));
+    }
+}
+
+QVariantMap ConfigManager::readSection(QSettings &settings, const QString &section)
+{
+    QVariantMap values;
+    settings.beginGroup(section);
+    for (const QString& key : settings.childKeys()) {
+        values.insert(key, settings.value(key));
+    }
+    settings.endGroup();
+    return values;
+}
+
+void ConfigManager::notifyChanged(int index)
+{
+    emit configChanged(m_sections[index]);
+    switch (index) {
+    case MysqlConfig::CONFIG_INDEX:
+        emit mysqlConfigChanged(snapshot<MysqlConfig>());
+        break;
+    case LoginConfig::CONFIG_INDEX:
+        emit loginConfigChanged(snapshot<LoginConfig>());
+        break;
+    case LogConfig::CONFIG_INDEX:
+        emit logConfigChanged(snapshot<LogConfig>());
+        break;
+    default:
+        break;
+    }
+}
+
+void ConfigManager::watchFile()
+{
+    if (!m_watcher->files().contains(m_iniPath) && QFile::exists(m_iniPath)) {
+        m_watcher->addPath(m_iniPath);
+    }
+}
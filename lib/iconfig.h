@@ -7,6 +7,16 @@
 #include<iostream>
 #include<exception>
 #include<QCryptographicHash>
+#include<QObject>
+#include<QVariantMap>
+#include<QFileSystemWatcher>
+#include<QTimer>
+#include<QThread>
+#include<QPointer>
+#include<QElapsedTimer>
+#include<memory>
+#include<atomic>
+#include<functional>
 ///
 /// \brief 抽象基类：所有设备配置类的统一接口
 ///
@@ -16,7 +26,7 @@ public:
     //加载配置（从Ini读取到内存）
     virtual void loadConfig(QSettings* settings)=0;
     //保存配置（从内存写入Ini）
-    virtual void saveConfig(QSettings *settings)=0;
+    virtual void saveConfig(QSettings *settings) const=0;
     // 虚析构函数：确保子类正确析构
     virtual~IConfig()=default;
     // 获取配置节（用于Ini文件的分组）
@@ -38,12 +48,23 @@ public:
         m_port = 3306;
         m_username = "root";
         m_password = "123456";
+        m_slowQueryMs = 500;
+        m_queryTimeoutMs = 30000;
+        m_lockWaitMs = 10000;
+        m_readTimeoutSec = 60;
+        m_readPort = 3306;
+        m_driver = DRIVER_MYSQL;
     }
+    // 数据库驱动：QMYSQL（默认）；QSQLITE（DbName为库文件名，相对路径基于程序目录）；
+    // MEMORY（进程内共享的SQLite内存库，无需服务器，用于测试与压测）
+    static constexpr const char* DRIVER_MYSQL = "QMYSQL";
+    static constexpr const char* DRIVER_SQLITE = "QSQLITE";
+    static constexpr const char* DRIVER_MEMORY = "MEMORY";
     // 统一实现加载配置
     void loadConfig(QSettings* settings) override;
 
     // 统一实现保存配置
-    void saveConfig(QSettings *settings) override;
+    void saveConfig(QSettings *settings) const override;
 
     // 统一的配置节规则
     QString getSection() const override
@@ -54,8 +75,9 @@ public:
     // 统一的配置信息格式化（调试验证用）
     QString getCurrentConfigInfo() const
     {
-        return QString("MySQL配置 [库名：%1] - 主机：%2，端口：%3，用户名：%4，密码：%5")
-                .arg(m_dbName).arg(m_host).arg(m_port).arg(m_username).arg(m_password);
+        return QString("MySQL配置 [库名：%1] - 驱动：%2，主机：%3，端口：%4，用户名：%5，密码：%6，只读副本：%7")
+                .arg(m_dbName).arg(m_driver).arg(m_host).arg(m_port).arg(m_username).arg(m_password)
+                .arg(hasReadReplica() ? QString("%1:%2").arg(m_readHost).arg(m_readPort) : QString("无"));
     }
     QList<QString> getPresetIps() const { return m_presetIps; }
     // 获取当前IP（选预设/手动输的）
@@ -73,6 +95,32 @@ public:
     void setPassword(const QString& password) { m_password = password; }
     QString getDbName() const { return m_dbName; }
     void setDbName(const QString& dbName) { m_dbName = dbName; }
+    // 只读副本地址（ReadHost为空表示不启用读写分离，读写都走主库）
+    QString getReadHost() const { return m_readHost; }
+    void setReadHost(const QString& host) { m_readHost = host.trimmed(); }
+    int getReadPort() const { return m_readPort; }
+    void setReadPort(int port) { m_readPort = port; }
+    bool hasReadReplica() const { return !m_readHost.isEmpty() && (m_readHost != m_host || m_readPort != m_port); }
+    QString getDriver() const { return m_driver; }
+    void setDriver(const QString& driver) { m_driver = normalizeDriver(driver); }
+    // 未识别的驱动名按QMYSQL处理
+    static QString normalizeDriver(const QString& driver)
+    {
+        QString name = driver.trimmed().toUpper();
+        return (name == DRIVER_SQLITE || name == DRIVER_MEMORY) ? name : QString(DRIVER_MYSQL);
+    }
+    // 慢查询阈值（毫秒，0表示不记录）
+    int getSlowQueryMs() const { return m_slowQueryMs; }
+    void setSlowQueryMs(int ms) { m_slowQueryMs = ms; }
+    // 查询默认超时（毫秒，0表示不限制；MySQL对SELECT生效）
+    int getQueryTimeoutMs() const { return m_queryTimeoutMs; }
+    void setQueryTimeoutMs(int ms) { m_queryTimeoutMs = ms; }
+    // 等待其它数据库操作释放连接的最长时间（毫秒，0表示一直等待）
+    int getLockWaitMs() const { return m_lockWaitMs; }
+    void setLockWaitMs(int ms) { m_lockWaitMs = ms; }
+    // MySQL驱动读写超时（秒，0表示不限制）：服务器无响应时断开连接
+    int getReadTimeoutSec() const { return m_readTimeoutSec; }
+    void setReadTimeoutSec(int sec) { m_readTimeoutSec = sec; }
 protected:
     const QList<QString> m_presetIps;
     QString m_host;
@@ -80,7 +128,13 @@ protected:
     QString m_username;
     QString m_password;
     QString m_dbName;
-    mutable QMutex m_mutex;
+    QString m_readHost;   // 只读副本主机（账号密码与主库一致）
+    int m_readPort;
+    int m_slowQueryMs;
+    int m_queryTimeoutMs;
+    int m_lockWaitMs;
+    int m_readTimeoutSec;
+    QString m_driver;
 };
 
 ///
@@ -89,6 +143,7 @@ protected:
 class MysqlConfig : public BaseMysqlConfig
 {
 public:
+    static constexpr int CONFIG_INDEX = 0; // ConfigManager中的类型编号
     MysqlConfig() : BaseMysqlConfig("dimensioncard") {}
 };
 ///
@@ -97,6 +152,7 @@ public:
 class LoginConfig:public IConfig
 {
 public:
+    static constexpr int CONFIG_INDEX = 1; // ConfigManager中的类型编号
     LoginConfig() {
        // 默认值
        m_lastAccount = "";
@@ -105,36 +161,30 @@ public:
    }
    void loadConfig(QSettings* settings) override;
    // 保存配置（从内存写入Ini）
-   void saveConfig(QSettings* settings) override;
+   void saveConfig(QSettings* settings) const override;
    // 配置节（Ini文件中的分组名）
    QString getSection() const override {
        return "Login"; // Ini中会生成[Login]节
    }
    // 对外的get/set接口
    QString getLastAccount() const {
-       QMutexLocker locker(&m_mutex);
        return m_lastAccount;
    }
    void setLastAccount(const QString& account) {
-       QMutexLocker locker(&m_mutex);
        m_lastAccount = account;
    }
 
    QString getLastPassword() const {
-       QMutexLocker locker(&m_mutex);
         return decrypt(m_lastPwdCipher); // 密文→明文
    }
    void setLastPassword(const QString& plainPassword){
-       QMutexLocker locker(&m_mutex);
        m_lastPwdCipher = encrypt(plainPassword); // 明文→密文
     }
 
    int getLastRoleValue() const {
-       QMutexLocker locker(&m_mutex);
        return m_lastRoleValue;
    }
    void setLastRoleValue(int value) {
-       QMutexLocker locker(&m_mutex);
        m_lastRoleValue = value;
    }
 public:
@@ -144,15 +194,125 @@ private:
     QString m_lastAccount;    // 上次登录的账号
     QString  m_lastPwdCipher;   // 上次登录的密码
     int m_lastRoleValue;      // 上次选中的角色值
-    mutable QMutex m_mutex;   // 线程安全锁
 };
 
 
+///
+/// \brief  日志配置（[Log]节）
+///
+class LogConfig : public IConfig
+{
+public:
+    static constexpr int CONFIG_INDEX = 2; // ConfigManager中的类型编号
+    // 日志队列满时的处理方式
+    static constexpr const char* FULL_BLOCK = "Block";          // 等待后台线程腾出空间，不丢日志
+    static constexpr const char* FULL_DROP = "Drop";            // 丢弃新日志并计数
+    static constexpr const char* FULL_DROP_DEBUG = "DropDebug"; // 只丢弃调试日志，其它等级等待
+    LogConfig() {
+        m_queueCapacity = 8192;
+        m_fullPolicy = FULL_DROP_DEBUG;
+        m_fileBufferBytes = 256 * 1024;
+        m_flushIntervalMs = 1000;
+        m_maxFileMB = 20;
+        m_rotateDaily = true;
+        m_maxFiles = 60;
+        m_maxAgeDays = 30;
+        m_maxTotalMB = 1024;
+        m_compress = true;
+        m_level = "Debug";
+        m_fileLevel = "Debug";
+        m_widgetLevel = "Debug";
+        m_widgetMaxLines = 5000;
+        m_structured = false;
+    }
+    void loadConfig(QSettings* settings) override;
+    void saveConfig(QSettings* settings) const override;
+    QString getSection() const override { return "Log"; }
+    // 日志队列容量（条，启动时生效，按2的幂向上取整）
+    int getQueueCapacity() const { return m_queueCapacity; }
+    void setQueueCapacity(int capacity) { m_queueCapacity = capacity; }
+    QString getFullPolicy() const { return m_fullPolicy; }
+    void setFullPolicy(const QString& policy) { m_fullPolicy = normalizeFullPolicy(policy); }
+    // 日志文件缓冲区（字节），写满后写入文件
+    int getFileBufferBytes() const { return m_fileBufferBytes; }
+    void setFileBufferBytes(int bytes) { m_fileBufferBytes = bytes; }
+    // 缓冲日志最长停留时间（毫秒），Error及以上等级立即写入
+    int getFlushIntervalMs() const { return m_flushIntervalMs; }
+    void setFlushIntervalMs(int ms) { m_flushIntervalMs = ms; }
+    // 单个日志文件超过该大小（MB）时换新文件（0不按大小轮转）
+    int getMaxFileMB() const { return m_maxFileMB; }
+    void setMaxFileMB(int mb) { m_maxFileMB = mb; }
+    // 跨天换新文件
+    bool getRotateDaily() const { return m_rotateDaily; }
+    void setRotateDaily(bool rotate) { m_rotateDaily = rotate; }
+    // 日志保留：文件数、天数、目录总大小（MB），0不限
+    int getMaxFiles() const { return m_maxFiles; }
+    void setMaxFiles(int count) { m_maxFiles = count; }
+    int getMaxAgeDays() const { return m_maxAgeDays; }
+    void setMaxAgeDays(int days) { m_maxAgeDays = days; }
+    int getMaxTotalMB() const { return m_maxTotalMB; }
+    void setMaxTotalMB(int mb) { m_maxTotalMB = mb; }
+    // 轮转下来的日志压缩为.gz
+    bool getCompress() const { return m_compress; }
+    void setCompress(bool compress) { m_compress = compress; }
+    // 最低输出等级（Debug/Info/Warn/Error/Fatal）：全局、文件、日志面板
+    QString getLevel() const { return m_level; }
+    void setLevel(const QString& level) { m_level = normalizeLevel(level); }
+    QString getFileLevel() const { return m_fileLevel; }
+    void setFileLevel(const QString& level) { m_fileLevel = normalizeLevel(level); }
+    QString getWidgetLevel() const { return m_widgetLevel; }
+    void setWidgetLevel(const QString& level) { m_widgetLevel = normalizeLevel(level); }
+    // 日志面板最多保留的行数
+    int getWidgetMaxLines() const { return m_widgetMaxLines; }
+    void setWidgetMaxLines(int lines) { m_widgetMaxLines = lines; }
+    // 同时写结构化二进制日志（启动时生效）
+    bool getStructured() const { return m_structured; }
+    void setStructured(bool structured) { m_structured = structured; }
+    // 未识别的策略按DropDebug处理
+    static QString normalizeFullPolicy(const QString& policy)
+    {
+        QString name = policy.trimmed();
+        if (name.compare(FULL_BLOCK, Qt::CaseInsensitive) == 0) return FULL_BLOCK;
+        if (name.compare(FULL_DROP, Qt::CaseInsensitive) == 0) return FULL_DROP;
+        return FULL_DROP_DEBUG;
+    }
+    // 未识别的等级按Debug处理
+    static QString normalizeLevel(const QString& level)
+    {
+        QString name = level.trimmed();
+        for (const char* known : {"Info", "Warn", "Error", "Fatal"}) {
+            if (name.compare(known, Qt::CaseInsensitive) == 0) return known;
+        }
+        return "Debug";
+    }
+private:
+    int m_queueCapacity;
+    QString m_fullPolicy;
+    int m_fileBufferBytes;
+    int m_flushIntervalMs;
+    int m_maxFileMB;
+    bool m_rotateDaily;
+    int m_maxFiles;
+    int m_maxAgeDays;
+    int m_maxTotalMB;
+    bool m_compress;
+    QString m_level;
+    QString m_fileLevel;
+    QString m_widgetLevel;
+    int m_widgetMaxLines;
+    bool m_structured;
+};
+
 ///
 /// \brief  配置管理类
+/// 每类配置按CONFIG_INDEX存放一份不可变快照：读取时原子取出shared_ptr，无锁且可跨线程长期持有；
+/// 修改时复制当前快照、在副本上修改后原子替换，已取出的旧快照不受影响。
+/// config.ini被外部修改后自动重新加载，只替换内容有变化的配置节并发出对应的变更信号。
+/// 修改过的配置节记为待保存，合并一段时间内的多次修改后在后台线程写入：先写临时文件，再整体替换config.ini
 ///
-class ConfigManager
+class ConfigManager : public QObject
 {
+    Q_OBJECT
 public:
     static ConfigManager&Get(){
         static ConfigManager instance;
@@ -160,58 +320,97 @@ public:
     }
     ConfigManager(const ConfigManager&)=delete;
     ConfigManager& operator =(const ConfigManager&)=delete;
+    // 已登记的配置类型数（各配置类的CONFIG_INDEX小于该值）
+    static constexpr int CONFIG_COUNT = 3;
 public:
+    // 读取配置快照
     template<typename T>
-      T& getConfig() {
-          QMutexLocker locker(&m_mutex);
-          // 遍历配置列表，找到对应类型的实例（dynamic_cast 类型安全）
-          for (IConfig* config : m_configList) {
-              if (T* targetConfig = dynamic_cast<T*>(config)) {
-                  return *targetConfig;
-              }
-          }
-          // 找不到时抛异常
-          throw std::runtime_error(QString("Config type %1 not registered").arg(typeid(T).name()).toStdString());
-      }
+    std::shared_ptr<const T> snapshot() const {
+        static_assert(T::CONFIG_INDEX >= 0 && T::CONFIG_INDEX < CONFIG_COUNT, "config type not registered");
+        std::shared_ptr<const IConfig> config = std::atomic_load(&m_configs[T::CONFIG_INDEX]);
+        // 找不到时抛异常
+        if (!config) {
+            throw std::runtime_error(QString("Config type %1 not registered").arg(typeid(T).name()).toStdString());
+        }
+        return std::static_pointer_cast<const T>(config);
+    }
+    // 修改配置：modify(T&)在当前快照的副本上修改，完成后发布为新快照并返回；写者之间串行。
+    // 该配置节记为待保存，稍后在后台写入文件
+    template<typename T, typename Modify>
+    std::shared_ptr<const T> update(Modify modify) {
+        std::shared_ptr<T> next;
+        {
+            QMutexLocker locker(&m_writeMutex);
+            next = std::make_shared<T>(*snapshot<T>());
+            modify(*next);
+            std::atomic_store(&m_configs[T::CONFIG_INDEX], std::shared_ptr<const IConfig>(next));
+            m_dirty |= 1u << T::CONFIG_INDEX;
+        }
+        requestSave();
+        return next;
+    }
 
 public:
-    // 手动触发保存所有配置
-   void saveAllConfig()
-   {
-       QMutexLocker locker(&m_mutex);
-       for (IConfig* config : m_configList) {
-            config->saveConfig(m_settings);
-       }
-       m_settings->sync(); // 强制写入文件，避免缓存
-   }
+    // 立即在调用线程写入全部待保存的配置节（等待进行中的后台写入），用于退出前或需要确认结果时；
+    // 失败时返回false并保留待保存标记
+    bool flush(QString* errorMsg = nullptr);
+    // 立即从config.ini重新加载（文件变化时会自动调用），返回内容有变化的配置节
+    QStringList reload();
 
-private:
-    ConfigManager()
-    {
-        QString  iniPath=QCoreApplication::applicationDirPath()+"/config.ini";
-        m_settings=new QSettings(iniPath,QSettings::IniFormat);
-        m_settings->setIniCodec("UTF-8");
-        //加载设备
-        m_configList.append(new MysqlConfig());
-        //
-        m_configList.append(new LoginConfig());
-        // 统一加载所有配置
-        for (IConfig* config : m_configList) {
-            config->loadConfig(m_settings);
-        }
+signals:
+    // 重新加载后按变化的配置节发出（在ConfigManager所在线程，即首次调用Get()的线程）
+    void configChanged(const QString& section);
+    void mysqlConfigChanged(std::shared_ptr<const MysqlConfig> config);
+    void loginConfigChanged(std::shared_ptr<const LoginConfig> config);
+    void logConfigChanged(std::shared_ptr<const LogConfig> config);
+    // 后台写入config.ini失败（修改仍保留在内存中，稍后自动重试）
+    void saveFailed(const QString& error);
 
+private:
+    ConfigManager();
+    ~ConfigManager() override;
+    // 从Ini加载一类配置并放入其编号对应的位置
+    template<typename T>
+    void registerConfig(QSettings& settings) {
+        static_assert(T::CONFIG_INDEX >= 0 && T::CONFIG_INDEX < CONFIG_COUNT, "CONFIG_INDEX out of range");
+        m_factories[T::CONFIG_INDEX] = []() { return std::shared_ptr<IConfig>(std::make_shared<T>()); };
+        std::shared_ptr<IConfig> config = m_factories[T::CONFIG_INDEX]();
+        m_sections[T::CONFIG_INDEX] = config->getSection();
+        config->loadConfig(&settings);
+        std::atomic_store(&m_configs[T::CONFIG_INDEX], std::shared_ptr<const IConfig>(config));
     }
-    ~ConfigManager()
-    {
-        // 析构时备份保存
-        saveAllConfig();
-        qDeleteAll(m_configList);
-        delete m_settings;
-    }
+    // 记录各配置节在文件中的原始键值，用于判断重新加载时哪些节发生了变化（调用方需持有m_fileMutex）
+    void rememberSectionsLocked(QSettings& settings);
+    // 有配置节待保存：排队到ConfigManager所在线程启动防抖计时（线程安全）
+    void requestSave();
+    // 防抖计时到期：取出待保存的配置交给后台线程写入
+    void startSave();
+    // 取出待保存配置的快照并清除标记，taken输出取出的配置编号（按位）
+    QList<std::shared_ptr<const IConfig>> takeDirty(unsigned* taken);
+    // 写入失败后恢复待保存标记
+    void restoreDirty(unsigned taken);
+    // 把configs写入文件：复制现有文件到临时文件、在临时文件上改写这些配置节，再原子替换config.ini
+    bool writeSections(const QList<std::shared_ptr<const IConfig>>& configs, QString* errorMsg = nullptr);
+    static QVariantMap readSection(QSettings& settings, const QString& section);
+    // 按编号发出变更信号
+    void notifyChanged(int index);
+    // 文件被替换（先写临时文件再改名）后监视会失效，需重新添加
+    void watchFile();
 private:
-    QSettings *m_settings;
-    QMutex m_mutex;
-    QList<IConfig*> m_configList;
+    QString m_iniPath;
+    QMutex m_writeMutex;  // 写者互斥（快照发布与待保存标记），读取不加锁
+    QMutex m_fileMutex;   // 文件读写互斥（保存与重新加载），同时保护m_sectionValues
+    unsigned m_dirty = 0; // 待保存的配置编号（按位）
+    std::shared_ptr<const IConfig> m_configs[CONFIG_COUNT];
+    std::function<std::shared_ptr<IConfig>()> m_factories[CONFIG_COUNT]; // 按编号创建默认配置
+    QString m_sections[CONFIG_COUNT];          // 默认配置对应的配置节
+    QMap<QString, QVariantMap> m_sectionValues; // 配置节→文件中的原始键值
+    QFileSystemWatcher* m_watcher = nullptr;
+    QTimer* m_reloadTimer = nullptr;            // 合并短时间内的多次文件变化
+    QTimer* m_saveTimer = nullptr;              // 合并短时间内的多次修改
+    QElapsedTimer m_dirtySince;                 // 最早一次未保存修改的时间（持续修改时也不无限推迟）
+    QPointer<QThread> m_saveThread;             // 进行中的后台写入
+    bool m_savePending = false;                 // 写入期间又有修改
 
 
 };
@@ -1,13 +1,50 @@
-﻿#include "ILogger.h"
+﻿#include "ilogger.h"
 #include <QCoreApplication>
 #include <QDir>
 #include<QDebug>
 #include <QThread>
 #include <QTextCodec>
+#include "iconfig.h"
+#include <csignal>
+#include <cstdio>
 
-// 格式器实现（无修改）
+// ===================== 日志上下文 =====================
+QString LogContext::text() const {
+    if (args.isEmpty()) return message;
+    return BinaryLog::expand(message, argTexts());
+}
+
+QStringList LogContext::argTexts() const {
+    QStringList texts;
+    texts.reserve(args.size());
+    for (const QVariant& arg : args) {
+        texts << arg.toString();
+    }
+    return texts;
+}
+
+QString LogContext::timeText() const {
+    // 同一秒内复用日期时间部分（本地时间转换较慢），只拼接毫秒
+    thread_local qint64 cachedSecond = -1;
+    thread_local QString cachedPrefix;
+    const qint64 second = timestampMs / 1000;
+    if (second != cachedSecond) {
+        cachedPrefix = QDateTime::fromMSecsSinceEpoch(second * 1000).toString("yyyy-MM-dd hh:mm:ss.");
+        cachedSecond = second;
+    }
+    const int millis = int(timestampMs % 1000);
+    QString result;
+    result.reserve(cachedPrefix.size() + 3);
+    result += cachedPrefix;
+    result += QLatin1Char(char('0' + millis / 100));
+    result += QLatin1Char(char('0' + millis / 10 % 10));
+    result += QLatin1Char(char('0' + millis % 10));
+    return result;
+}
+
+// 格式器实现
 QString BasicLogFormatter::format(const LogContext& context) {
-    QString timeStr = context.timestamp.toString("yyyy-MM-dd hh:mm:ss.zzz");
+    QString timeStr = context.timeText();
     QString levelStr;
     switch (context.level) {
         case LogLevel::Debug: levelStr = "[DEBUG]"; break;
@@ -19,11 +56,11 @@ QString BasicLogFormatter::format(const LogContext& context) {
 //    QString threadStr = QString("[Thread:%1]").arg(context.threadId);
 
     return QString("%1 %2 %3 ")
-           .arg(timeStr, levelStr,context.message);
+           .arg(timeStr, levelStr, context.text());
 }
 
 QString DeviceLogFormatter::format(const LogContext& context) {
-    QString timeStr = context.timestamp.toString("yyyy-MM-dd hh:mm:ss.zzz");
+    QString timeStr = context.timeText();
     QString levelStr;
     switch (context.level) {
         case LogLevel::Debug: levelStr = "[DEBUG]"; break;
@@ -36,56 +73,132 @@ QString DeviceLogFormatter::format(const LogContext& context) {
     QString deviceStr = QString("[Device:%1]").arg(context.device.isEmpty() ? "Unknown" : context.device);
 
     return QString("%1 %2 %3 %4 %5")
-           .arg(timeStr, deviceStr, levelStr, threadStr, context.message);
+           .arg(timeStr, deviceStr, levelStr, threadStr, context.text());
 }
 
-// ===================== 输出器基类实现（无修改） =====================
+// ===================== 输出器基类实现 =====================
 void LogAppender::append(const LogContext& context, const QString& formattedMsg) {
     QMutexLocker locker(&m_mutex);
-    if (m_enabled) {
+    if (m_enabled && context.level >= m_minLevel) {
         doAppend(context, formattedMsg);
     }
 }
 
-// ===================== 控件输出器实现（无修改） =====================
+void LogAppender::maintain() {
+    QMutexLocker locker(&m_mutex);
+    doMaintain();
+}
+
+// ===================== 控件输出器实现 =====================
+// 界面刷新间隔
+static const int WIDGET_FLUSH_INTERVAL_MS = 50;
+
 WidgetAppender::WidgetAppender(QObject *parent) : LogAppender(parent) {
-    connect(this, &WidgetAppender::signalAppendText,
-            this, &WidgetAppender::onAppendText,
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(WIDGET_FLUSH_INTERVAL_MS);
+    connect(&m_flushTimer, &QTimer::timeout, this, &WidgetAppender::onFlushTimeout);
+    connect(this, &WidgetAppender::signalScheduleFlush,
+            this, &WidgetAppender::onScheduleFlush,
             Qt::QueuedConnection);
 }
 
 void WidgetAppender::bindWidget(QTextEdit* widget) {
     m_widget = widget;
     m_isPlainTextEdit = false;
+    widget->document()->setMaximumBlockCount(m_maxLines.load());
 }
 
 void WidgetAppender::bindWidget(QPlainTextEdit* widget) {
     m_widget = widget;
     m_isPlainTextEdit = true;
+    widget->document()->setMaximumBlockCount(m_maxLines.load());
 }
 
-void WidgetAppender::onAppendText(const QString& text) {
-    if (!m_widget) return;
+void WidgetAppender::setMaxLines(int maxLines) {
+    // 可能在后台线程调用，文本框的行数上限在下次刷新时更新
+    m_maxLines = qMax(100, maxLines);
+}
+
+QTextDocument* WidgetAppender::document() const {
+    if (!m_widget) return nullptr;
     if (m_isPlainTextEdit) {
-        QPlainTextEdit* plainEdit = static_cast<QPlainTextEdit*>(m_widget);
-        plainEdit->appendPlainText(text);
-        QTextCursor cursor = plainEdit->textCursor();
-        cursor.movePosition(QTextCursor::End);
-        plainEdit->setTextCursor(cursor);
+        return static_cast<QPlainTextEdit*>(m_widget.data())->document();
+    }
+    return static_cast<QTextEdit*>(m_widget.data())->document();
+}
+
+void WidgetAppender::onScheduleFlush() {
+    if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+void WidgetAppender::onFlushTimeout() {
+    QStringList lines;
+    quint64 dropped = 0;
+    {
+        QMutexLocker locker(&m_pendingMutex);
+        lines.swap(m_pending);
+        dropped = m_droppedLines;
+        m_droppedLines = 0;
+        m_flushScheduled = false;
+    }
+    QTextDocument* doc = document();
+    if (!doc || (lines.isEmpty() && dropped == 0)) return;
+
+    const int maxLines = m_maxLines.load();
+    if (doc->maximumBlockCount() != maxLines) {
+        doc->setMaximumBlockCount(maxLines);
+    }
+    if (dropped > 0) {
+        lines.prepend(QString("……日志输出过快，面板跳过%1条（完整内容见日志文件）").arg(dropped));
+    }
+    // 一次编辑追加全部行，超出上限的最早行由文档自动删除
+    QTextCursor cursor(doc);
+    cursor.movePosition(QTextCursor::End);
+    cursor.beginEditBlock();
+    for (const QString& line : lines) {
+        if (!doc->isEmpty()) {
+            cursor.insertBlock();
+        }
+        cursor.insertText(line);
+    }
+    cursor.endEditBlock();
+
+    if (m_isPlainTextEdit) {
+        QPlainTextEdit* plainEdit = static_cast<QPlainTextEdit*>(m_widget.data());
+        plainEdit->moveCursor(QTextCursor::End);
+        plainEdit->ensureCursorVisible();
     } else {
-        QTextEdit* textEdit = static_cast<QTextEdit*>(m_widget);
-        textEdit->append(text);
-        QTextCursor cursor = textEdit->textCursor();
-        cursor.movePosition(QTextCursor::End);
-        textEdit->setTextCursor(cursor);
+        QTextEdit* textEdit = static_cast<QTextEdit*>(m_widget.data());
+        textEdit->moveCursor(QTextCursor::End);
+        textEdit->ensureCursorVisible();
     }
 }
 
 void WidgetAppender::doAppend(const LogContext& context, const QString& formattedMsg) {
-    emit signalAppendText(formattedMsg);
+    Q_UNUSED(context);
+    bool schedule = false;
+    {
+        QMutexLocker locker(&m_pendingMutex);
+        m_pending.append(formattedMsg);
+        // 界面跟不上时只保留最新的行（更早的行显示后也会被行数上限删掉）
+        const int maxLines = m_maxLines.load();
+        while (m_pending.size() > maxLines) {
+            m_pending.removeFirst();
+            ++m_droppedLines;
+        }
+        if (!m_flushScheduled) {
+            m_flushScheduled = true;
+            schedule = true;
+        }
+    }
+    if (schedule) {
+        emit signalScheduleFlush();
+    }
 }
 
-// ===================== 文件输出器实现（无修改） =====================
+// ===================== 文件输出器实现 =====================
 FileAppender::FileAppender(const QString& customLogDir, QObject *parent)
     : LogAppender(parent) {
     if (!customLogDir.isEmpty()) {
@@ -99,31 +212,103 @@ FileAppender::FileAppender(const QString& customLogDir, QObject *parent)
         dir.mkpath(m_logDir);
     }
 
+    m_archivePool.setMaxThreadCount(1);
+    openLogFileLocked();
+    // 预留容量后清空缓冲区不会释放内存
+    m_buffer.reserve(m_bufferBytes);
+    m_lastWrite.start();
+}
+
+FileAppender::~FileAppender() {
+    flush();
+    m_logFile.close();
+    LogArchive::setActiveFiles(this, QStringList());
+    // 未开始的整理任务放弃，下次启动时再处理
+    m_archivePool.clear();
+    m_archivePool.waitForDone();
+}
+
+void FileAppender::openLogFileLocked() {
     m_logFile.setFileName(getLogFileName());
-    if (m_logFile.open(QIODevice::Append | QIODevice::Text)) {
-        m_logStream.setDevice(&m_logFile);
-        m_logStream.setCodec("UTF-8");
-    }
-    else
-    {
+    LogArchive::setActiveFiles(this, QStringList() << m_logFile.fileName());
+    m_fileDate = QDate::currentDate();
+    if (!m_logFile.open(QIODevice::Append | QIODevice::Text)) {
         qWarning() << "日志文件打开失败：" << m_logFile.errorString();
     }
 }
 
-FileAppender::~FileAppender() {
-    flush();
+void FileAppender::rotateLocked() {
     m_logFile.close();
+    openLogFileLocked();
+    scheduleArchiveLocked();
+}
+
+void FileAppender::scheduleArchiveLocked() {
+    m_archivePool.start(LogArchive::createTask(m_logDir, m_archivePolicy));
+}
+
+void FileAppender::setRotation(qint64 maxFileBytes, bool rotateDaily, const LogArchive::Policy &policy) {
+    QMutexLocker locker(&m_fileMutex);
+    m_maxFileBytes = maxFileBytes;
+    m_rotateDaily = rotateDaily;
+    m_archivePolicy = policy;
+    scheduleArchiveLocked();
 }
 
 void FileAppender::flush() {
     QMutexLocker locker(&m_fileMutex);
-    m_logStream.flush();
-    m_logFile.flush();
+    writeBufferLocked();
+}
+
+void FileAppender::flushOnCrash() {
+    // 不轮转：信号处理中只做最少的事
+    const bool locked = m_fileMutex.tryLock();
+    if (m_logFile.isOpen() && !m_buffer.isEmpty()) {
+        m_logFile.write(m_buffer);
+        m_logFile.flush();
+        m_buffer.resize(0);
+    }
+    if (locked) {
+        m_fileMutex.unlock();
+    }
+}
+
+void FileAppender::setFlushPolicy(int bufferBytes, int intervalMs) {
+    QMutexLocker locker(&m_fileMutex);
+    m_bufferBytes = bufferBytes;
+    m_flushIntervalMs = intervalMs;
+    if (m_buffer.capacity() < bufferBytes) {
+        m_buffer.reserve(bufferBytes);
+    }
+    if (m_buffer.size() >= m_bufferBytes) {
+        writeBufferLocked();
+    }
+}
+
+void FileAppender::writeBufferLocked() {
+    if (!m_buffer.isEmpty()) {
+        const bool tooLarge = m_maxFileBytes > 0 && m_logFile.size() > 0
+                && m_logFile.size() + m_buffer.size() > m_maxFileBytes;
+        const bool nextDay = m_rotateDaily && QDate::currentDate() != m_fileDate;
+        if (tooLarge || nextDay) {
+            rotateLocked();
+        }
+    }
+    if (m_logFile.isOpen() && !m_buffer.isEmpty()) {
+        m_logFile.write(m_buffer);
+        m_logFile.flush();
+    }
+    m_buffer.resize(0);
+    m_lastWrite.restart();
 }
 
 QString FileAppender::getLogFileName() {
     QString timeStr = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
-    return QString("%1/%2_Log.txt").arg(m_logDir, timeStr);
+    QString fileName = QString("%1/%2_Log.txt").arg(m_logDir, timeStr);
+    for (int index = 1; QFile::exists(fileName) || QFile::exists(fileName + ".gz"); ++index) {
+        fileName = QString("%1/%2_Log_%3.txt").arg(m_logDir, timeStr).arg(index);
+    }
+    return fileName;
 }
 
 QString FileAppender::getDefaultLogDir() {
@@ -134,23 +319,167 @@ QString FileAppender::getDefaultLogDir() {
 void FileAppender::doAppend(const LogContext& context, const QString& formattedMsg) {
     QMutexLocker locker(&m_fileMutex);
     if (!m_logFile.isOpen()) return;
-    m_logStream << formattedMsg << endl;
-    m_logStream.flush();
-    m_logFile.flush();
+    m_buffer.append(formattedMsg.toUtf8());
+    m_buffer.append('\n');
+    // 错误日志立即落盘，便于崩溃后排查
+    if (m_buffer.size() >= m_bufferBytes || context.level >= LogLevel::Error
+            || m_lastWrite.elapsed() >= m_flushIntervalMs) {
+        writeBufferLocked();
+    }
+}
+
+void FileAppender::doMaintain() {
+    QMutexLocker locker(&m_fileMutex);
+    if (!m_buffer.isEmpty() && m_lastWrite.elapsed() >= m_flushIntervalMs) {
+        writeBufferLocked();
+    }
 }
 
-// ===================== 日志管理器实现（关键修改：移除ConsoleAppender注册） =====================
+// ===================== 二进制输出器实现 =====================
+BinaryLogAppender::BinaryLogAppender(const QString &customLogDir, QObject *parent)
+    : LogAppender(parent) {
+    m_logDir = customLogDir.isEmpty()
+            ? QString("%1/Log").arg(QCoreApplication::applicationDirPath()) : customLogDir;
+    QDir().mkpath(m_logDir);
+    openLocked();
+    m_lastWrite.start();
+}
+
+BinaryLogAppender::~BinaryLogAppender() {
+    QMutexLocker locker(&m_fileMutex);
+    m_writer.close();
+    LogArchive::setActiveFiles(this, QStringList());
+}
+
+void BinaryLogAppender::openLocked() {
+    const QString timeStr = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
+    QString basePath = QString("%1/%2_Log").arg(m_logDir, timeStr);
+    for (int index = 1; QFile::exists(basePath + BinaryLog::dataSuffix()); ++index) {
+        basePath = QString("%1/%2_Log_%3").arg(m_logDir, timeStr).arg(index);
+    }
+    LogArchive::setActiveFiles(this, QStringList() << basePath + BinaryLog::dataSuffix()
+                               << basePath + BinaryLog::stringSuffix() << basePath + BinaryLog::indexSuffix());
+    m_fileDate = QDate::currentDate();
+    QString errorMsg;
+    if (!m_writer.open(basePath, &errorMsg)) {
+        qWarning() << "结构化日志文件打开失败：" << errorMsg;
+    }
+}
+
+void BinaryLogAppender::flushLocked() {
+    m_writer.flush();
+    m_lastWrite.restart();
+    const bool tooLarge = m_maxFileBytes > 0 && m_writer.dataBytes() > m_maxFileBytes;
+    const bool nextDay = m_rotateDaily && QDate::currentDate() != m_fileDate;
+    if (m_writer.isOpen() && (tooLarge || nextDay)) {
+        m_writer.close();
+        openLocked();
+    }
+}
+
+void BinaryLogAppender::flush() {
+    QMutexLocker locker(&m_fileMutex);
+    flushLocked();
+}
+
+void BinaryLogAppender::flushOnCrash() {
+    const bool locked = m_fileMutex.tryLock();
+    m_writer.flush();
+    if (locked) {
+        m_fileMutex.unlock();
+    }
+}
+
+void BinaryLogAppender::setFlushPolicy(int bufferBytes, int intervalMs) {
+    QMutexLocker locker(&m_fileMutex);
+    m_bufferBytes = bufferBytes;
+    m_flushIntervalMs = intervalMs;
+}
+
+void BinaryLogAppender::setRotation(qint64 maxFileBytes, bool rotateDaily) {
+    QMutexLocker locker(&m_fileMutex);
+    m_maxFileBytes = maxFileBytes;
+    m_rotateDaily = rotateDaily;
+}
+
+void BinaryLogAppender::doAppend(const LogContext &context, const QString &formattedMsg) {
+    Q_UNUSED(formattedMsg);
+    BinaryLogWriter::Entry entry;
+    entry.timestampMs = context.timestampMs;
+    entry.level = static_cast<int>(context.level);
+    entry.device = context.device;
+    entry.threadId = context.threadId;
+    entry.message = context.message;
+    entry.args = context.argTexts();
+
+    QMutexLocker locker(&m_fileMutex);
+    m_writer.append(entry);
+    if (m_writer.bufferedBytes() >= m_bufferBytes || context.level >= LogLevel::Error
+            || m_lastWrite.elapsed() >= m_flushIntervalMs) {
+        flushLocked();
+    }
+}
+
+void BinaryLogAppender::doMaintain() {
+    QMutexLocker locker(&m_fileMutex);
+    if (m_writer.bufferedBytes() > 0 && m_lastWrite.elapsed() >= m_flushIntervalMs) {
+        flushLocked();
+    }
+}
+
+// ===================== 日志管理器实现 =====================
+// 后台线程每批最多处理的条数；队列空时的最长等待（兼作定时检查丢弃计数）
+static const int CONSUMER_BATCH_SIZE = 256;
+static const int CONSUMER_IDLE_WAIT_MS = 100;
+// 单调时钟按系统时间校准的间隔
+static const int CLOCK_SYNC_MS = 1000;
+
+// 崩溃处理使用的日志管理器（析构后置空，信号处理中只写出一次）
+static std::atomic<LoggerManager*> g_crashLogger{nullptr};
+static QtMessageHandler g_previousMessageHandler = nullptr;
+
 LoggerManager::LoggerManager() {
     // 注册默认格式器
     registerFormatter("Basic", new BasicLogFormatter());
     registerFormatter("Device", new DeviceLogFormatter());
     setCurrentFormatter("Basic"); // 默认使用设备格式器
 
+    m_clock.start();
+    syncClock();
+
+    // 队列容量启动时确定；满队列策略、等级、文件缓冲与轮转随config.ini热加载更新
+    std::shared_ptr<const LogConfig> config = ConfigManager::Get().snapshot<LogConfig>();
+    m_queue.reset(new LogRingBuffer<LogContext>(config->getQueueCapacity()));
+    applyConfig(config);
+    QObject::connect(&ConfigManager::Get(), &ConfigManager::logConfigChanged,
+                     [](std::shared_ptr<const LogConfig> changed) {
+        LoggerManager::Get().applyConfig(changed);
+    });
+
     // 仅注册文件输出器（移除了控制台输出器），控件输出器在MainWindow中注册
     registerAppender(new FileAppender());
+    // 结构化日志启动时决定是否启用
+    if (config->getStructured()) {
+        registerAppender(new BinaryLogAppender());
+    }
+
+    m_running = true;
+    m_consumer = QThread::create([this]() { consumeLoop(); });
+    m_consumer->start();
+
+    g_crashLogger = this;
+    installCrashHandlers();
 }
 
 LoggerManager::~LoggerManager() {
+    g_crashLogger = nullptr;
+    // 停止后台线程：先写完队列中剩余的日志
+    m_running = false;
+    wakeConsumer();
+    m_consumer->wait();
+    delete m_consumer;
+    m_consumer = nullptr;
+
     QMutexLocker locker(&m_mutex);
     qDeleteAll(m_formatters);
     m_formatters.clear();
@@ -158,6 +487,110 @@ LoggerManager::~LoggerManager() {
     m_appenders.clear();
 }
 
+LoggerManager::FullPolicy LoggerManager::parseFullPolicy(const QString &policy) {
+    const QString name = LogConfig::normalizeFullPolicy(policy);
+    if (name == LogConfig::FULL_BLOCK) return FullPolicy::Block;
+    if (name == LogConfig::FULL_DROP) return FullPolicy::Drop;
+    return FullPolicy::DropDebug;
+}
+
+void LoggerManager::applyConfig(std::shared_ptr<const LogConfig> config) {
+    setFullPolicy(parseFullPolicy(config->getFullPolicy()));
+    QMutexLocker locker(&m_mutex);
+    m_config = config;
+    m_minLevel = static_cast<int>(parseLevel(config->getLevel()));
+    for (LogAppender* appender : m_appenders) {
+        configureAppenderLocked(appender);
+    }
+    updateThresholdLocked();
+}
+
+void LoggerManager::configureAppenderLocked(LogAppender *appender) {
+    if (!m_config) return;
+    if (FileAppender* fileAppender = dynamic_cast<FileAppender*>(appender)) {
+        fileAppender->setMinLevel(parseLevel(m_config->getFileLevel()));
+        fileAppender->setFlushPolicy(m_config->getFileBufferBytes(), m_config->getFlushIntervalMs());
+        LogArchive::Policy policy;
+        policy.compress = m_config->getCompress();
+        policy.maxFiles = m_config->getMaxFiles();
+        policy.maxAgeDays = m_config->getMaxAgeDays();
+        policy.maxTotalBytes = qint64(m_config->getMaxTotalMB()) * 1024 * 1024;
+        fileAppender->setRotation(qint64(m_config->getMaxFileMB()) * 1024 * 1024, m_config->getRotateDaily(), policy);
+    } else if (BinaryLogAppender* binaryAppender = dynamic_cast<BinaryLogAppender*>(appender)) {
+        binaryAppender->setMinLevel(parseLevel(m_config->getFileLevel()));
+        binaryAppender->setFlushPolicy(m_config->getFileBufferBytes(), m_config->getFlushIntervalMs());
+        binaryAppender->setRotation(qint64(m_config->getMaxFileMB()) * 1024 * 1024, m_config->getRotateDaily());
+    } else if (WidgetAppender* widgetAppender = dynamic_cast<WidgetAppender*>(appender)) {
+        widgetAppender->setMinLevel(parseLevel(m_config->getWidgetLevel()));
+        widgetAppender->setMaxLines(m_config->getWidgetMaxLines());
+    }
+}
+
+void LoggerManager::updateThresholdLocked() {
+    // 所有启用的输出器都不输出的等级也可直接跳过
+    int lowest = static_cast<int>(LogLevel::Fatal) + 1;
+    for (LogAppender* appender : m_appenders) {
+        if (appender->isEnabled()) {
+            lowest = qMin(lowest, static_cast<int>(appender->minLevel()));
+        }
+    }
+    m_threshold = qMax(m_minLevel, lowest);
+}
+
+void LoggerManager::setMinLevel(LogLevel level) {
+    QMutexLocker locker(&m_mutex);
+    m_minLevel = static_cast<int>(level);
+    updateThresholdLocked();
+}
+
+LogLevel LoggerManager::parseLevel(const QString &level) {
+    const QString name = LogConfig::normalizeLevel(level);
+    if (name == "Info") return LogLevel::Info;
+    if (name == "Warn") return LogLevel::Warn;
+    if (name == "Error") return LogLevel::Error;
+    if (name == "Fatal") return LogLevel::Fatal;
+    return LogLevel::Debug;
+}
+
+void LoggerManager::syncClock() {
+    m_clockOffsetMs = QDateTime::currentMSecsSinceEpoch() - m_clock.elapsed();
+}
+
+void LoggerManager::installCrashHandlers() {
+    g_previousMessageHandler = qInstallMessageHandler(&LoggerManager::fatalMessageHandler);
+    for (int sig : {SIGSEGV, SIGABRT, SIGFPE, SIGILL, SIGTERM}) {
+        std::signal(sig, &LoggerManager::crashSignalHandler);
+    }
+}
+
+void LoggerManager::fatalMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message) {
+    LoggerManager* logger = g_crashLogger.load();
+    if (type == QtFatalMsg && logger) {
+        if (QThread::currentThread() == logger->m_consumer) {
+            // 后台线程写出时出错，可能已持有m_mutex
+            logger->flushOnCrash();
+        } else {
+            logger->log(LogLevel::Fatal, message);
+            logger->flushAllFileAppenders();
+        }
+    }
+    if (g_previousMessageHandler) {
+        g_previousMessageHandler(type, context, message);
+    } else {
+        fprintf(stderr, "%s\n", qPrintable(qFormatLogMessage(type, context, message)));
+        fflush(stderr);
+    }
+}
+
+void LoggerManager::crashSignalHandler(int sig) {
+    if (LoggerManager* logger = g_crashLogger.exchange(nullptr)) {
+        logger->flushOnCrash();
+    }
+    // 恢复默认处理并重新触发，保留系统的崩溃行为（转储/退出码）
+    std::signal(sig, SIG_DFL);
+    std::raise(sig);
+}
+
 void LoggerManager::registerFormatter(const QString& name, LogFormatter* formatter) {
     QMutexLocker locker(&m_mutex);
     if (m_formatters.contains(name)) {
@@ -176,15 +609,23 @@ void LoggerManager::setCurrentFormatter(const QString& name) {
 void LoggerManager::registerAppender(LogAppender* appender) {
     QMutexLocker locker(&m_mutex);
     m_appenders.append(appender);
+    configureAppenderLocked(appender);
+    updateThresholdLocked();
+}
+
+// 线程ID文本每个线程只生成一次
+static const QString& currentThreadIdText() {
+    thread_local const QString threadId = QString::number(reinterpret_cast<quintptr>(QThread::currentThreadId()), 16);
+    return threadId;
 }
 
 LogContext LoggerManager::buildContext(LogLevel level, const QString& device, const QString& message) {
     LogContext context;
-    context.timestamp = QDateTime::currentDateTime();
+    context.timestampMs = currentTimeMs();
     context.level = level;
     context.device = device;
     context.message = message;
-    context.threadId = QString::number(reinterpret_cast<quintptr>(QThread::currentThreadId()), 16);
+    context.threadId = currentThreadIdText();
     return context;
 }
 
@@ -193,22 +634,140 @@ void LoggerManager::log(LogLevel level, const QString& message) {
 }
 
 void LoggerManager::log(LogLevel level, const QString& device, const QString& message) {
-    QMutexLocker locker(&m_mutex);
-    if (!m_currentFormatter) return;
-
+    if (!isLevelEnabled(level)) return;
     LogContext context = buildContext(level, device, message);
-    QString formattedMsg = m_currentFormatter->format(context);
+    enqueue(context);
+}
+
+void LoggerManager::enqueue(LogContext &context) {
+    // 后台线程已停止（退出阶段）或输出器内部再打日志：直接写出，避免等待自己
+    if (!m_running || QThread::currentThread() == m_consumer) {
+        writeBatch(std::vector<LogContext>(1, context));
+        return;
+    }
+    if (!m_queue->tryPush(context)) {
+        const FullPolicy policy = static_cast<FullPolicy>(m_fullPolicy.load());
+        if (policy == FullPolicy::Drop || (policy == FullPolicy::DropDebug && context.level == LogLevel::Debug)) {
+            ++m_dropped;
+            ++m_droppedTotal;
+            return;
+        }
+        // 等待后台线程腾出空间
+        do {
+            wakeConsumer();
+            QThread::yieldCurrentThread();
+        } while (!m_queue->tryPush(context));
+    }
+    ++m_enqueued;
+    // 与后台线程设置等待标志后的再次检查配对，保证不会漏掉唤醒
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_consumerWaiting.load()) {
+        wakeConsumer();
+    }
+}
+
+void LoggerManager::wakeConsumer() {
+    QMutexLocker locker(&m_wakeMutex);
+    m_wakeCondition.wakeOne();
+}
+
+void LoggerManager::consumeLoop() {
+    std::vector<LogContext> batch;
+    batch.reserve(CONSUMER_BATCH_SIZE);
+    LogContext context;
+    QElapsedTimer sinceSync;
+    sinceSync.start();
+    while (true) {
+        batch.clear();
+        while (batch.size() < size_t(CONSUMER_BATCH_SIZE) && m_queue->tryPop(context)) {
+            batch.push_back(std::move(context));
+        }
+        if (!batch.empty() || m_dropped.load() > 0) {
+            writeBatch(batch);
+            m_processed += batch.size();
+            QMutexLocker locker(&m_wakeMutex);
+            m_drainedCondition.wakeAll();
+            continue;
+        }
+        if (!m_running) break;
+        {
+            QMutexLocker locker(&m_wakeMutex);
+            m_consumerWaiting = true;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_queue->isEmpty() && m_running) {
+                m_wakeCondition.wait(&m_wakeMutex, CONSUMER_IDLE_WAIT_MS);
+            }
+            m_consumerWaiting = false;
+        }
+        // 空闲时按时间写出文件缓冲、校准时钟
+        maintainAppenders();
+        if (sinceSync.elapsed() >= CLOCK_SYNC_MS) {
+            syncClock();
+            sinceSync.restart();
+        }
+    }
+}
 
+void LoggerManager::maintainAppenders() {
+    QMutexLocker locker(&m_mutex);
     for (LogAppender* appender : m_appenders) {
-        appender->append(context, formattedMsg);
+        appender->maintain();
+    }
+}
+
+void LoggerManager::writeBatch(const std::vector<LogContext>& batch) {
+    QMutexLocker locker(&m_mutex);
+    if (!m_currentFormatter) return;
+    // 报告队列满时丢弃的条数
+    const quint64 dropped = m_dropped.exchange(0);
+    if (dropped > 0) {
+        LogContext notice = buildContext(LogLevel::Warn, "", QString("日志队列已满，丢弃%1条日志").arg(dropped));
+        QString formattedMsg = m_currentFormatter->format(notice);
+        for (LogAppender* appender : m_appenders) {
+            appender->append(notice, formattedMsg);
+        }
+    }
+    for (const LogContext& context : batch) {
+        QString formattedMsg = m_currentFormatter->format(context);
+        for (LogAppender* appender : m_appenders) {
+            appender->append(context, formattedMsg);
+        }
+    }
+}
+
+void LoggerManager::waitForDrain() {
+    if (!m_running || QThread::currentThread() == m_consumer) return;
+    const quint64 target = m_enqueued.load();
+    QMutexLocker locker(&m_wakeMutex);
+    m_wakeCondition.wakeOne();
+    while (m_processed.load() < target && m_running) {
+        m_drainedCondition.wait(&m_wakeMutex, CONSUMER_IDLE_WAIT_MS);
     }
 }
 
 void LoggerManager::flushAllFileAppenders() {
+    waitForDrain();
     QMutexLocker locker(&m_mutex);
     for (LogAppender* appender : m_appenders) {
         if (FileAppender* fileAppender = dynamic_cast<FileAppender*>(appender)) {
             fileAppender->flush();
+        } else if (BinaryLogAppender* binaryAppender = dynamic_cast<BinaryLogAppender*>(appender)) {
+            binaryAppender->flush();
         }
     }
 }
+
+void LoggerManager::flushOnCrash() {
+    // 只写出已在输出器缓冲区中的日志；队列中尚未取出的日志无法在信号处理中安全读取
+    const bool locked = m_mutex.tryLock();
+    for (LogAppender* appender : m_appenders) {
+        if (FileAppender* fileAppender = dynamic_cast<FileAppender*>(appender)) {
+            fileAppender->flushOnCrash();
+        } else if (BinaryLogAppender* binaryAppender = dynamic_cast<BinaryLogAppender*>(appender)) {
+            binaryAppender->flushOnCrash();
+        }
+    }
+    if (locked) {
+        m_mutex.unlock();
+    }
+}
@@ -12,6 +12,20 @@
 #include <QThread>
 #include <QList>
 #include <QMap>
+#include <QVariant>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QPointer>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <QThreadPool>
+#include "logringbuffer.h"
+#include "logarchive.h"
+#include "binarylog.h"
+
+class LogConfig;
 
 // 日志等级（保留基础等级，无冗余逻辑）
 enum class LogLevel {
@@ -24,11 +38,19 @@ enum class LogLevel {
 
 // 日志上下文（保留核心字段，简化无冗余）
 struct LogContext {
-    QDateTime timestamp;   // 时间戳（精确到毫秒）
-    LogLevel level;        // 日志等级
+    qint64 timestampMs = 0; // 时间戳（自1970-01-01 UTC的毫秒数）
+    LogLevel level = LogLevel::Info; // 日志等级
     QString device;        // 设备名
-    QString message;       // 日志内容
+    QString message;       // 日志内容（args非空时为%1..%n模板）
+    QVariantList args;     // 模板参数，写出时才展开
     QString threadId;      // 线程ID（调试用）
+
+    // 展开模板后的日志内容
+    QString text() const;
+    // 参数文本
+    QStringList argTexts() const;
+    // 本地时间文本：yyyy-MM-dd hh:mm:ss.zzz
+    QString timeText() const;
 };
 
 // 抽象格式器（定义日志格式，仅保留基础+设备两种）
@@ -59,20 +81,29 @@ public:
 
     void setEnabled(bool enabled) { m_enabled = enabled; }
     bool isEnabled() const { return m_enabled; }
+    // 最低输出等级（通过LoggerManager设置，以便同步更新全局过滤等级）
+    void setMinLevel(LogLevel level) { m_minLevel = level; }
+    LogLevel minLevel() const { return m_minLevel; }
 
     // 对外接口：线程安全的日志输出
     void append(const LogContext& context, const QString& formattedMsg);
+    // 后台线程每写完一批或空闲等待超时后调用，用于按时间处理缓冲内容
+    void maintain();
 
 protected:
     // 子类实现具体输出逻辑
     virtual void doAppend(const LogContext& context, const QString& formattedMsg) = 0;
+    virtual void doMaintain() {}
 
 private:
     bool m_enabled = true;
+    LogLevel m_minLevel = LogLevel::Debug;
     mutable QMutex m_mutex; // 线程安全锁
 };
 
-// Qt控件输出器（实时输出到文本框，支持跨线程）
+// Qt控件输出器（输出到文本框，支持跨线程）
+// 日志行先放入待显示列表，每50ms在界面线程一次性追加；文本框最多保留maxLines行，
+// 界面来不及显示时丢弃最早的待显示行，并追加一行说明丢弃条数
 class WidgetAppender : public LogAppender {
     Q_OBJECT
 public:
@@ -81,23 +112,37 @@ public:
     // 绑定Qt文本控件（QTextEdit/QPlainTextEdit）
     void bindWidget(QTextEdit* widget);
     void bindWidget(QPlainTextEdit* widget);
+    // 文本框最多保留的行数（同时是待显示行数上限）
+    void setMaxLines(int maxLines);
 
 signals:
-    // 跨线程更新控件的信号（确保实时且安全）
-    void signalAppendText(const QString& text);
+    // 待显示列表由空变为非空时发出，在界面线程启动刷新定时器
+    void signalScheduleFlush();
 
 private slots:
-    void onAppendText(const QString& text);
+    void onScheduleFlush();
+    void onFlushTimeout();
 
 protected:
     void doAppend(const LogContext& context, const QString& formattedMsg) override;
 
 private:
-    QWidget* m_widget = nullptr;
+    QTextDocument* document() const;
+
+private:
+    QPointer<QWidget> m_widget;
     bool m_isPlainTextEdit = false;
+    QTimer m_flushTimer;
+    QMutex m_pendingMutex;        // 保护待显示列表
+    QStringList m_pending;
+    quint64 m_droppedLines = 0;   // 未显示就被丢弃的行数
+    bool m_flushScheduled = false;
+    std::atomic<int> m_maxLines{5000};
 };
 
 // 文件输出器（支持自定义目录，默认：可执行文件同级/Log）
+// 日志先写入内存缓冲区，缓冲区写满、距上次写入超过间隔、或遇到Error及以上等级时一次写入文件；
+// 文件超过大小或跨天时换新文件，旧文件在后台压缩并按保留策略清理
 class FileAppender : public LogAppender {
     Q_OBJECT
 public:
@@ -107,12 +152,27 @@ public:
 
     // 手动刷盘（窗口关闭时调用，确保日志全部写入文件）
     void flush();
+    // 崩溃时尽力写出缓冲区：不等待文件锁（持锁的可能正是崩溃的线程）
+    void flushOnCrash();
+    // 缓冲区大小（字节）与最长停留时间（毫秒）
+    void setFlushPolicy(int bufferBytes, int intervalMs);
+    // 轮转（maxFileBytes为0时不按大小轮转）与归档策略；设置后整理一次日志目录
+    void setRotation(qint64 maxFileBytes, bool rotateDaily, const LogArchive::Policy& policy);
 
 protected:
     void doAppend(const LogContext& context, const QString& formattedMsg) override;
+    void doMaintain() override;
 
 private:
-    // 生成文件名：yyyyMMdd_HHmmss_Log.txt（时间_Log格式）
+    // 缓冲区写入文件，需要时先换新文件（调用方持有m_fileMutex）
+    void writeBufferLocked();
+    // 打开新的日志文件
+    void openLogFileLocked();
+    // 关闭当前文件换新文件，旧文件交给后台整理
+    void rotateLocked();
+    void scheduleArchiveLocked();
+
+    // 生成文件名：yyyyMMdd_HHmmss_Log.txt（时间_Log格式，同一秒内重名时加_序号）
     QString getLogFileName();
     // 获取默认日志目录：可执行文件同级/Log
     QString getDefaultLogDir();
@@ -120,11 +180,61 @@ private:
 private:
     QString m_logDir;       // 最终日志目录（自定义/默认）
     QFile m_logFile;
-    QTextStream m_logStream;
+    QByteArray m_buffer;    // 待写入的UTF-8文本
+    int m_bufferBytes = 256 * 1024;
+    int m_flushIntervalMs = 1000;
+    QElapsedTimer m_lastWrite;
+    QDate m_fileDate;       // 当前文件的创建日期
+    qint64 m_maxFileBytes = 20LL * 1024 * 1024;
+    bool m_rotateDaily = true;
+    LogArchive::Policy m_archivePolicy;
+    QThreadPool m_archivePool; // 单线程，整理任务依次执行
     QMutex m_fileMutex;     // 文件操作锁
 };
 
-// 日志管理器（单例，简化无冗余）
+// 结构化二进制输出器（[Log]Structured=true时注册，与文本日志同目录）
+// 保存时间、等级、设备、线程与消息模板+参数，不做文本格式化；用tools/logquery按时间/等级/设备查询。
+// 按与文本日志相同的大小/日期规则换文件，旧文件的保留与删除由文本日志的整理任务一并处理
+class BinaryLogAppender : public LogAppender {
+    Q_OBJECT
+public:
+    explicit BinaryLogAppender(const QString& customLogDir = "", QObject *parent = nullptr);
+    ~BinaryLogAppender() override;
+
+    void flush();
+    // 崩溃时尽力写出缓冲区，不等待文件锁
+    void flushOnCrash();
+    // 缓冲区大小（字节）与最长停留时间（毫秒）
+    void setFlushPolicy(int bufferBytes, int intervalMs);
+    // 轮转（.dlog超过maxFileBytes或跨天时换文件，maxFileBytes为0时不按大小轮转）
+    void setRotation(qint64 maxFileBytes, bool rotateDaily);
+
+protected:
+    void doAppend(const LogContext& context, const QString& formattedMsg) override;
+    void doMaintain() override;
+
+private:
+    // 写出缓冲区，需要时换新文件（调用方持有m_fileMutex）
+    void flushLocked();
+    // 打开新文件：yyyyMMdd_HHmmss_Log（同一秒内重名时加_序号）
+    void openLocked();
+
+private:
+    BinaryLogWriter m_writer;
+    QString m_logDir;
+    int m_bufferBytes = 256 * 1024;
+    int m_flushIntervalMs = 1000;
+    QElapsedTimer m_lastWrite;
+    QDate m_fileDate;       // 当前文件的创建日期
+    qint64 m_maxFileBytes = 20LL * 1024 * 1024;
+    bool m_rotateDaily = true;
+    QMutex m_fileMutex;
+};
+
+// 日志管理器（单例）
+// 调用线程只构建上下文并压入无锁队列，由一个后台线程批量格式化并写入各输出器；
+// 队列满时按[Log]FullPolicy等待或丢弃。
+// 低于全局等级、且所有启用的输出器都不输出的等级在宏中直接跳过，消息参数不会求值
 class LoggerManager {
 public:
     static LoggerManager& Get() {
@@ -152,15 +262,49 @@ public:
                 appender->setEnabled(enabled);
             }
         }
+        updateThresholdLocked();
+    }
+    // 设置指定类型输出器的最低等级（config.ini热加载时按配置重置）
+    template<typename T>
+    void setAppenderMinLevel(LogLevel level) {
+        QMutexLocker locker(&m_mutex);
+        for (LogAppender* appender : m_appenders) {
+            if (dynamic_cast<T*>(appender)) {
+                appender->setMinLevel(level);
+            }
+        }
+        updateThresholdLocked();
+    }
+    // 全局最低等级
+    void setMinLevel(LogLevel level);
+    // 该等级的日志是否会被输出
+    bool isLevelEnabled(LogLevel level) const {
+        return static_cast<int>(level) >= m_threshold.load(std::memory_order_relaxed);
     }
 
     // 核心日志接口（无设备名）
     void log(LogLevel level, const QString& message);
     // 核心日志接口（带设备名）
     void log(LogLevel level, const QString& device, const QString& message);
+    // 模板日志：只保存模板与参数，由后台线程展开（%1..%n，同QString::arg）
+    template<typename... Args>
+    void logf(LogLevel level, const QString& device, const QString& pattern, const Args&... args) {
+        if (!isLevelEnabled(level)) return;
+        LogContext context = buildContext(level, device, pattern);
+        context.args = QVariantList{QVariant(args)...};
+        enqueue(context);
+    }
 
-    // 手动刷盘所有文件输出器（窗口关闭时调用）
+    // 手动刷盘所有文件输出器（窗口关闭时调用）：先等待调用前入队的日志全部写出
     void flushAllFileAppenders();
+    // 崩溃时（信号处理函数中）尽力写出文件缓冲区，不等待任何锁
+    void flushOnCrash();
+
+    // 队列满时的处理方式
+    enum class FullPolicy { Block, Drop, DropDebug };
+    void setFullPolicy(FullPolicy policy) { m_fullPolicy.store(static_cast<int>(policy)); }
+    // 累计丢弃的日志条数
+    quint64 droppedCount() const { return m_droppedTotal.load(); }
 
 private:
     LoggerManager();
@@ -168,25 +312,85 @@ private:
 
     // 构建日志上下文
     LogContext buildContext(LogLevel level, const QString& device, const QString& message);
+    // 入队，队列满时按策略等待或丢弃
+    void enqueue(LogContext& context);
+    // 后台线程：取出日志批量写出，队列空时等待唤醒
+    void consumeLoop();
+    // 格式化并写入各输出器（调用方不能持有m_mutex）
+    void writeBatch(const std::vector<LogContext>& batch);
+    // 等待调用前入队的日志全部写出
+    void waitForDrain();
+    void wakeConsumer();
+    static FullPolicy parseFullPolicy(const QString& policy);
+    // 应用[Log]配置（启动时及config.ini热加载后）
+    void applyConfig(std::shared_ptr<const LogConfig> config);
+    // 按当前配置设置输出器（调用方持有m_mutex）
+    void configureAppenderLocked(LogAppender* appender);
+    // 重新计算宏中使用的过滤等级（调用方持有m_mutex）
+    void updateThresholdLocked();
+    static LogLevel parseLevel(const QString& level);
+    // 当前时间（毫秒）：单调时钟加偏移，后台线程定期按系统时间校准偏移
+    qint64 currentTimeMs() const { return m_clockOffsetMs.load(std::memory_order_relaxed) + m_clock.elapsed(); }
+    void syncClock();
+    // 各输出器的定时处理（后台线程调用）
+    void maintainAppenders();
+    // 安装qFatal消息处理与崩溃信号处理，退出前写出缓冲的日志
+    static void installCrashHandlers();
+    static void fatalMessageHandler(QtMsgType type, const QMessageLogContext& context, const QString& message);
+    static void crashSignalHandler(int sig);
 
 private:
-    QMutex m_mutex;
+    QMutex m_mutex;           // 保护格式器与输出器列表（后台线程写出时持有）
     QMap<QString, LogFormatter*> m_formatters;
     LogFormatter* m_currentFormatter = nullptr;
     QList<LogAppender*> m_appenders;
+    std::shared_ptr<const LogConfig> m_config;
+    int m_minLevel = static_cast<int>(LogLevel::Debug);
+    std::atomic<int> m_threshold{static_cast<int>(LogLevel::Debug)}; // max(全局等级, 启用输出器的最低等级)
+    QElapsedTimer m_clock;
+    std::atomic<qint64> m_clockOffsetMs{0};
+
+    std::unique_ptr<LogRingBuffer<LogContext>> m_queue;
+    std::atomic<int> m_fullPolicy{static_cast<int>(FullPolicy::DropDebug)};
+    std::atomic<quint64> m_enqueued{0};      // 已入队条数
+    std::atomic<quint64> m_processed{0};     // 已写出条数
+    std::atomic<quint64> m_dropped{0};       // 待报告的丢弃条数
+    std::atomic<quint64> m_droppedTotal{0};  // 累计丢弃条数
+    std::atomic<bool> m_running{false};      // 后台线程运行中（停止后日志在调用线程直接写出）
+    std::atomic<bool> m_consumerWaiting{false};
+    QMutex m_wakeMutex;
+    QWaitCondition m_wakeCondition;          // 唤醒后台线程
+    QWaitCondition m_drainedCondition;       // 一批写出完成
+    QThread* m_consumer = nullptr;
 };
 
-// 便捷宏定义（简化调用）
-#define LOG_DEBUG(msg) LoggerManager::Get().log(LogLevel::Debug, "", msg)
-#define LOG_INFO(msg)  LoggerManager::Get().log(LogLevel::Info, "", msg)
-#define LOG_WARN(msg)  LoggerManager::Get().log(LogLevel::Warn, "", msg)
-#define LOG_ERROR(msg) LoggerManager::Get().log(LogLevel::Error, "", msg)
-#define LOG_FATAL(msg) LoggerManager::Get().log(LogLevel::Fatal, "", msg)
-
-#define LOG_DEVICE_DEBUG(device, msg) LoggerManager::Get().log(LogLevel::Debug, device, msg)
-#define LOG_DEVICE_INFO(device, msg)  LoggerManager::Get().log(LogLevel::Info, device, msg)
-#define LOG_DEVICE_WARN(device, msg)  LoggerManager::Get().log(LogLevel::Warn, device, msg)
-#define LOG_DEVICE_ERROR(device, msg) LoggerManager::Get().log(LogLevel::Error, device, msg)
-#define LOG_DEVICE_FATAL(device, msg) LoggerManager::Get().log(LogLevel::Fatal, device, msg)
+// 便捷宏定义（简化调用）：先检查等级，被过滤时不求值msg
+#define LOG_AT(level, device, msg) \
+    do { if (LoggerManager::Get().isLevelEnabled(level)) LoggerManager::Get().log(level, device, msg); } while (0)
+// 模板形式：LOG_DEBUGF("读取%1条，耗时%2ms", rows, elapsed)，参数在后台线程格式化
+#define LOG_AT_F(level, device, ...) \
+    do { if (LoggerManager::Get().isLevelEnabled(level)) LoggerManager::Get().logf(level, device, __VA_ARGS__); } while (0)
+
+#define LOG_DEBUG(msg) LOG_AT(LogLevel::Debug, "", msg)
+#define LOG_INFO(msg)  LOG_AT(LogLevel::Info, "", msg)
+#define LOG_WARN(msg)  LOG_AT(LogLevel::Warn, "", msg)
+#define LOG_ERROR(msg) LOG_AT(LogLevel::Error, "", msg)
+#define LOG_FATAL(msg) LOG_AT(LogLevel::Fatal, "", msg)
+
+#define LOG_DEVICE_DEBUG(device, msg) LOG_AT(LogLevel::Debug, device, msg)
+#define LOG_DEVICE_INFO(device, msg)  LOG_AT(LogLevel::Info, device, msg)
+#define LOG_DEVICE_WARN(device, msg)  LOG_AT(LogLevel::Warn, device, msg)
+#define LOG_DEVICE_ERROR(device, msg) LOG_AT(LogLevel::Error, device, msg)
+#define LOG_DEVICE_FATAL(device, msg) LOG_AT(LogLevel::Fatal, device, msg)
+
+#define LOG_DEBUGF(...) LOG_AT_F(LogLevel::Debug, "", __VA_ARGS__)
+#define LOG_INFOF(...)  LOG_AT_F(LogLevel::Info, "", __VA_ARGS__)
+#define LOG_WARNF(...)  LOG_AT_F(LogLevel::Warn, "", __VA_ARGS__)
+#define LOG_ERRORF(...) LOG_AT_F(LogLevel::Error, "", __VA_ARGS__)
+
+#define LOG_DEVICE_DEBUGF(device, ...) LOG_AT_F(LogLevel::Debug, device, __VA_ARGS__)
+#define LOG_DEVICE_INFOF(device, ...)  LOG_AT_F(LogLevel::Info, device, __VA_ARGS__)
+#define LOG_DEVICE_WARNF(device, ...)  LOG_AT_F(LogLevel::Warn, device, __VA_ARGS__)
+#define LOG_DEVICE_ERRORF(device, ...) LOG_AT_F(LogLevel::Error, device, __VA_ARGS__)
 
 #endif // ILOGGER_H
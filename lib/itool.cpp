@@ -3,17 +3,8 @@
 
 QString DbSyncTool::getFieldNameByColumn(int col, const QString &tableName)
 {
-    // 1. 执行DESC语句查询表结构
-   QString descSql = QString("DESC %1").arg(tableName);
-   SqlService::QueryResult descResult = SqlService::Get().GetData(descSql); // 适配你的SqlService单例调用
-
-   // 2. 校验结果：查询失败/列号越界 → 返回空
-   if (!descResult.success || col < 0 || col >= descResult.data.size()) {
-       return "";
-   }
-
-   // 3. 返回对应列号的字段名
-   return descResult.data[col].value("Field").toString();
+    // 从表结构缓存取字段名（仅首次访问该表时执行DESC）
+    return SqlService::Get().getTableSchema(tableName).columnAt(col);
 }
 
 void DbSyncTool::syncCellEditToDb(QStandardItem *editedItem, QStandardItemModel *model, const QString &tableName, const QString &primaryKey, QWidget *parent)
@@ -60,3 +51,153 @@ void DbSyncTool::syncCellEditToDb(QStandardItem *editedItem, QStandardItemModel
 
 
 
+
+
+void DbSyncTool::syncCellEditToDbAsync(QStandardItem *editedItem, QStandardItemModel *model, const QString &tableName, const QString &primaryKey, QWidget *parent)
+{
+    if (!editedItem || !model) {
+        if (parent) QMessageBox::warning(parent, "提示", "入参无效，同步失败！");
+        return;
+    }
+    // 与已提交值相同（包括回滚恢复触发的itemChanged）不再写回
+    if (editedItem->text() == editedItem->data(Qt::UserRole).toString()) {
+        return;
+    }
+    QStandardItem* pkItem = model->item(editedItem->row(), 0);
+    QString pkValue = pkItem ? pkItem->text().trimmed() : "";
+
+    QString fieldName = getFieldNameByColumn(editedItem->column(), tableName);
+    if (fieldName.isEmpty()) {
+        if (parent) QMessageBox::warning(parent, "提示", "无法匹配字段名，同步失败！");
+        editedItem->setText(editedItem->data(Qt::UserRole).toString());
+        return;
+    }
+    ToolManager::Get().cellEditQueue().enqueue(editedItem, tableName, primaryKey, pkValue, fieldName, parent);
+}
+
+// ===================== 单元格编辑写回队列 =====================
+CellEditWriteQueue::CellEditWriteQueue(QObject *parent) : QObject(parent)
+{
+    // 先构造SqlService，保证其析构晚于本队列（析构时仍需提交积压编辑）
+    SqlService::Get();
+
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(200);
+    connect(&m_flushTimer, &QTimer::timeout, this, &CellEditWriteQueue::flush);
+
+    m_worker = new QObject();
+    m_worker->moveToThread(&m_workerThread);
+    connect(&m_workerThread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_workerThread.start();
+}
+
+CellEditWriteQueue::~CellEditWriteQueue()
+{
+    m_flushTimer.stop();
+    // 退出前同步提交积压编辑（此时界面已销毁，不再回写单元格）
+    QList<RowUpdate> batch = m_pending.values();
+    m_pending.clear();
+    QMetaObject::invokeMethod(m_worker, [batch]() {
+        if (!batch.isEmpty()) execBatch(batch);
+    }, Qt::BlockingQueuedConnection);
+    m_workerThread.quit();
+    m_workerThread.wait();
+}
+
+void CellEditWriteQueue::enqueue(QStandardItem *editedItem, const QString &tableName, const QString &primaryKey,
+                                 const QString &pkValue, const QString &fieldName, QWidget *parent)
+{
+    if (!editedItem || !editedItem->model()) return;
+
+    QString key = tableName + QChar('\x1f') + pkValue;
+    RowUpdate& row = m_pending[key];
+    row.tableName = tableName;
+    row.primaryKey = primaryKey;
+    row.pkValue = pkValue;
+
+    CellEdit edit;
+    edit.index = QPersistentModelIndex(editedItem->index());
+    edit.fieldName = fieldName;
+    edit.newValue = editedItem->text();
+    edit.parent = parent;
+    row.edits.insert(fieldName, edit); // 同一字段多次编辑只保留最后一次
+
+    if (m_pending.size() >= m_flushThreshold) {
+        flush();
+    } else if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+void CellEditWriteQueue::flush()
+{
+    m_flushTimer.stop();
+    if (m_pending.isEmpty()) return;
+
+    QList<RowUpdate> batch = m_pending.values();
+    m_pending.clear();
+    QPointer<CellEditWriteQueue> self(this);
+    QMetaObject::invokeMethod(m_worker, [self, batch]() {
+        QList<SqlService::QueryResult> results = execBatch(batch);
+        if (!self) return;
+        QMetaObject::invokeMethod(self.data(), [self, batch, results]() {
+            if (self) self->applyResults(batch, results);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+QList<SqlService::QueryResult> CellEditWriteQueue::execBatch(const QList<RowUpdate> &batch)
+{
+    QList<SqlService::SqlStatement> statements;
+    for (const RowUpdate& row : batch) {
+        SqlService::SqlStatement statement;
+        QStringList assignments;
+        for (const CellEdit& edit : row.edits) {
+            assignments.append(QString("%1 = ?").arg(edit.fieldName));
+            statement.params.append(edit.newValue);
+        }
+        statement.sql = QString("UPDATE %1 SET %2 WHERE %3 = ?")
+                .arg(row.tableName).arg(assignments.join(", ")).arg(row.primaryKey);
+        statement.params.append(row.pkValue);
+        statements.append(statement);
+    }
+    return SqlService::Get().ExecTransaction(statements);
+}
+
+void CellEditWriteQueue::applyResults(const QList<RowUpdate> &batch, const QList<SqlService::QueryResult> &results)
+{
+    int successCount = 0;
+    int failCount = 0;
+    QPointer<QWidget> warnParent;
+    QString firstError;
+
+    for (int i = 0; i < batch.size(); ++i) {
+        const RowUpdate& row = batch[i];
+        bool ok = i < results.size() && results[i].success;
+        QString errorMsg = i < results.size() ? results[i].errorMsg : "未返回执行结果";
+        for (const CellEdit& edit : row.edits) {
+            const QStandardItemModel* model = qobject_cast<const QStandardItemModel*>(edit.index.model());
+            QStandardItem* item = (model && edit.index.isValid()) ? model->itemFromIndex(edit.index) : nullptr;
+            if (ok) {
+                ++successCount;
+                if (item) item->setData(edit.newValue, Qt::UserRole); // 记录新值，用于失败恢复
+                continue;
+            }
+            ++failCount;
+            // 单元格已被再次修改的，不覆盖用户后续输入
+            if (item && item->text() == edit.newValue.toString()) {
+                item->setText(item->data(Qt::UserRole).toString());
+            }
+            if (!warnParent && edit.parent) {
+                warnParent = edit.parent;
+                firstError = errorMsg;
+            }
+            emit editFailed(row.tableName, row.pkValue, edit.fieldName, errorMsg);
+        }
+    }
+
+    emit flushFinished(successCount, failCount);
+    if (failCount > 0 && warnParent) {
+        QMessageBox::warning(warnParent, "提示", QString("数据同步失败%1项：%2").arg(failCount).arg(firstError));
+    }
+}
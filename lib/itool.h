@@ -7,6 +7,10 @@
 #include <QStandardItemModel>
 #include <QWidget>
 #include <QMessageBox>
+#include <QPersistentModelIndex>
+#include <QPointer>
+#include <QTimer>
+#include <QThread>
 //QT       +=axcontainer
 #include <QAxObject>
 #include <QAxWidget>
@@ -28,7 +32,67 @@ public:
                           const QString& tableName, const QString& primaryKey,
                           QWidget *parent = nullptr);//单表更新
 
+    // 异步写回：编辑进入写回队列合并提交，失败时按Qt::UserRole回滚（不阻塞界面）
+    void syncCellEditToDbAsync(QStandardItem *editedItem, QStandardItemModel *model,
+                               const QString& tableName, const QString& primaryKey,
+                               QWidget *parent = nullptr);
+};
+
+///
+/// \brief 单元格编辑写回队列
+/// 按(表,主键)合并编辑为一条多字段UPDATE，定时或达到阈值后在后台线程用一个事务提交，
+/// 结果回到界面线程逐项处理：成功更新Qt::UserRole，失败恢复为Qt::UserRole中的旧值
+///
+class CellEditWriteQueue : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CellEditWriteQueue(QObject *parent = nullptr);
+    ~CellEditWriteQueue() override;
+
+    // 加入一次单元格编辑（界面线程调用）
+    void enqueue(QStandardItem *editedItem, const QString& tableName, const QString& primaryKey,
+                 const QString& pkValue, const QString& fieldName, QWidget *parent = nullptr);
+    // 立即提交当前积压的编辑
+    void flush();
 
+    void setFlushInterval(int ms) { m_flushTimer.setInterval(ms); }
+    void setFlushThreshold(int rowCount) { m_flushThreshold = qMax(1, rowCount); }
+
+signals:
+    // 单项写回失败（已回滚）
+    void editFailed(const QString& tableName, const QString& pkValue,
+                    const QString& fieldName, const QString& errorMsg);
+    // 一次提交完成
+    void flushFinished(int successCount, int failCount);
+
+private:
+    // 单个单元格的待写回编辑
+    struct CellEdit {
+        QPersistentModelIndex index;  // 单元格位置（行增删后仍有效）
+        QString fieldName;
+        QVariant newValue;
+        QPointer<QWidget> parent;     // 失败提示的父窗口
+    };
+    // 同一(表,主键)下合并后的行更新
+    struct RowUpdate {
+        QString tableName;
+        QString primaryKey;
+        QString pkValue;
+        QMap<QString, CellEdit> edits; // 字段名→最后一次编辑
+    };
+
+    // 在工作线程执行：每行一条UPDATE，整批一个事务
+    static QList<SqlService::QueryResult> execBatch(const QList<RowUpdate>& batch);
+    // 回到界面线程：逐项确认或回滚
+    void applyResults(const QList<RowUpdate>& batch, const QList<SqlService::QueryResult>& results);
+
+private:
+    QMap<QString, RowUpdate> m_pending; // 键：表名+主键值
+    QTimer m_flushTimer;
+    int m_flushThreshold = 50;          // 积压行数阈值
+    QThread m_workerThread;
+    QObject* m_worker = nullptr;        // 工作线程上下文对象
 };
 
 
@@ -48,10 +112,13 @@ public:
 
     // 获取数据库同步工具
     DbSyncTool& dbSync() { return m_dbSyncTool; }
+    // 获取单元格编辑写回队列
+    CellEditWriteQueue& cellEditQueue() { return m_cellEditQueue; }
 
 
 private:
     DbSyncTool m_dbSyncTool;
+    CellEditWriteQueue m_cellEditQueue;
 };
 
 #endif // TOOLMANAGER_H
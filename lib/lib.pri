@@ -1,15 +1,38 @@
 HEADERS += \
+    $$PWD/binarylog.h \
     $$PWD/iconfig.h \
     $$PWD/ilogger.h \
     $$PWD/itool.h \
     $$PWD/loadqss.h \
+    $$PWD/logarchive.h \
+    $$PWD/logringbuffer.h \
+    $$PWD/measurementcsv.h \
+    $$PWD/measurementimport.h \
+    $$PWD/productcache.h \
+    $$PWD/productcatalog.h \
+    $$PWD/productquery.h \
+    $$PWD/querycache.h \
+    $$PWD/reportqueue.h \
     $$PWD/reporttool.h \
-    $$PWD/sqlservice.h
+    $$PWD/sqlfixture.h \
+    $$PWD/sqlservice.h \
+    $$PWD/sqlstats.h
 
 SOURCES += \
+    $$PWD/binarylog.cpp \
     $$PWD/iconfig.cpp \
     $$PWD/ilogger.cpp \
     $$PWD/itool.cpp \
     $$PWD/loadqss.cpp \
+    $$PWD/logarchive.cpp \
+    $$PWD/measurementcsv.cpp \
+    $$PWD/measurementimport.cpp \
+    $$PWD/productcache.cpp \
+    $$PWD/productcatalog.cpp \
+    $$PWD/productquery.cpp \
+    $$PWD/querycache.cpp \
+    $$PWD/reportqueue.cpp \
     $$PWD/reporttool.cpp \
-    $$PWD/sqlservice.cpp
+    $$PWD/sqlfixture.cpp \
+    $$PWD/sqlservice.cpp \
+    $$PWD/sqlstats.cpp
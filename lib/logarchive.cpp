@@ -0,0 +1,180 @@
+﻿#include "logarchive.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QDebug>
+#include <QMutex>
+#include <QHash>
+#include <QSet>
+
+// 超过该大小的文件不压缩（整体读入内存压缩）
+static const qint64 MAX_COMPRESS_BYTES = 256LL * 1024 * 1024;
+
+namespace {
+class HousekeepTask : public QRunnable
+{
+public:
+    HousekeepTask(const QString& logDir, const LogArchive::Policy& policy)
+        : m_logDir(logDir), m_policy(policy) {}
+    void run() override { LogArchive::housekeep(m_logDir, m_policy); }
+
+private:
+    QString m_logDir;
+    LogArchive::Policy m_policy;
+};
+
+// 各输出器正在写入的文件（绝对路径）
+struct ActiveFiles {
+    QMutex mutex;
+    QHash<const void*, QStringList> files;
+};
+
+ActiveFiles& activeFiles()
+{
+    static ActiveFiles instance;
+    return instance;
+}
+}
+
+QStringList LogArchive::nameFilters()
+{
+    return QStringList() << "*_Log*.txt" << "*_Log*.txt.gz" << "*_Log*.dlog" << "*_Log*.dstr" << "*_Log*.didx";
+}
+
+QRunnable *LogArchive::createTask(const QString &logDir, const Policy &policy)
+{
+    return new HousekeepTask(logDir, policy);
+}
+
+void LogArchive::setActiveFiles(const void *owner, const QStringList &files)
+{
+    QStringList paths;
+    for (const QString& file : files) {
+        paths << QFileInfo(file).absoluteFilePath();
+    }
+    ActiveFiles& active = activeFiles();
+    QMutexLocker locker(&active.mutex);
+    if (paths.isEmpty()) {
+        active.files.remove(owner);
+    } else {
+        active.files.insert(owner, paths);
+    }
+}
+
+void LogArchive::housekeep(const QString &logDir, const Policy &policy)
+{
+    QDir dir(logDir);
+    QSet<QString> activePaths;
+    {
+        ActiveFiles& active = activeFiles();
+        QMutexLocker locker(&active.mutex);
+        for (const QStringList& paths : active.files) {
+            for (const QString& path : paths) activePaths.insert(path);
+        }
+    }
+    if (policy.compress) {
+        for (const QFileInfo& info : dir.entryInfoList(QStringList() << "*_Log*.txt", QDir::Files, QDir::Name)) {
+            if (activePaths.contains(info.absoluteFilePath()) || info.size() > MAX_COMPRESS_BYTES) continue;
+            QString errorMsg;
+            if (!compressFile(info.absoluteFilePath(), &errorMsg)) {
+                qWarning() << "日志压缩失败：" << errorMsg;
+            }
+        }
+    }
+
+    // 文件名以创建时间开头，按名称排序即从旧到新
+    QFileInfoList files = dir.entryInfoList(nameFilters(), QDir::Files, QDir::Name);
+    qint64 totalBytes = 0;
+    for (const QFileInfo& info : files) {
+        totalBytes += info.size();
+    }
+    const QDateTime expire = QDateTime::currentDateTime().addDays(-policy.maxAgeDays);
+    int remaining = files.size();
+    for (const QFileInfo& info : files) {
+        if (activePaths.contains(info.absoluteFilePath())) continue;
+        const bool expired = policy.maxAgeDays > 0 && info.lastModified() < expire;
+        const bool tooMany = policy.maxFiles > 0 && remaining > policy.maxFiles;
+        const bool tooLarge = policy.maxTotalBytes > 0 && totalBytes > policy.maxTotalBytes;
+        if (!expired && !tooMany && !tooLarge) continue;
+        if (QFile::remove(info.absoluteFilePath())) {
+            --remaining;
+            totalBytes -= info.size();
+        }
+    }
+}
+
+bool LogArchive::compressFile(const QString &filePath, QString *errorMsg)
+{
+    QFile source(filePath);
+    if (!source.open(QIODevice::ReadOnly)) {
+        if (errorMsg) *errorMsg = QString("%1：%2").arg(filePath, source.errorString());
+        return false;
+    }
+    const QByteArray data = source.readAll();
+    source.close();
+    if (data.isEmpty()) {
+        return QFile::remove(filePath);
+    }
+    const quint32 mtime = quint32(QFileInfo(filePath).lastModified().toMSecsSinceEpoch() / 1000);
+
+    // 先写临时文件再替换，中途退出不会留下残缺的.gz
+    QSaveFile target(filePath + ".gz");
+    const QByteArray content = gzip(data, mtime);
+    if (!target.open(QIODevice::WriteOnly) || target.write(content) != content.size() || !target.commit()) {
+        if (errorMsg) *errorMsg = QString("%1.gz：%2").arg(filePath, target.errorString());
+        return false;
+    }
+    if (!QFile::remove(filePath)) {
+        if (errorMsg) *errorMsg = QString("已压缩但无法删除：%1").arg(filePath);
+        return false;
+    }
+    return true;
+}
+
+QByteArray LogArchive::gzip(const QByteArray &data, quint32 mtime)
+{
+    // qCompress输出：4字节原长度（大端）+ zlib流（2字节头 + deflate数据 + 4字节Adler-32），
+    // gzip复用其中的deflate数据，换上gzip头和CRC-32/长度尾
+    const QByteArray zlib = qCompress(data);
+    const QByteArray deflate = zlib.mid(6, zlib.size() - 10);
+
+    QByteArray out;
+    out.reserve(deflate.size() + 18);
+    const char header[] = {
+        char(0x1f), char(0x8b), 8, 0,
+        char(mtime & 0xff), char((mtime >> 8) & 0xff), char((mtime >> 16) & 0xff), char((mtime >> 24) & 0xff),
+        0, char(0xff)
+    };
+    out.append(header, sizeof(header));
+    out.append(deflate);
+    const quint32 crc = crc32(data);
+    const quint32 size = quint32(data.size());
+    for (int shift = 0; shift < 32; shift += 8) out.append(char((crc >> shift) & 0xff));
+    for (int shift = 0; shift < 32; shift += 8) out.append(char((size >> shift) & 0xff));
+    return out;
+}
+
+quint32 LogArchive::crc32(const QByteArray &data)
+{
+    static const struct Table {
+        quint32 values[256];
+        Table() {
+            for (quint32 i = 0; i < 256; ++i) {
+                quint32 c = i;
+                for (int k = 0; k < 8; ++k) {
+                    c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+                }
+                values[i] = c;
+            }
+        }
+    } table;
+
+    quint32 crc = 0xFFFFFFFFu;
+    const uchar* bytes = reinterpret_cast<const uchar*>(data.constData());
+    for (int i = 0; i < data.size(); ++i) {
+        crc = table.values[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
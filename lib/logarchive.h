@@ -0,0 +1,42 @@
+﻿#ifndef LOGARCHIVE_H
+#define LOGARCHIVE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QRunnable>
+
+///
+/// \brief 日志归档
+/// 轮转下来的文本日志压缩为gzip（<文件名>.gz），再按文件数、保留天数、目录总大小删除最旧的日志
+/// （含结构化日志的.dlog/.dstr/.didx，每组三个文件分别计数）。
+/// 整理任务由FileAppender放入单线程的线程池依次执行；各输出器登记正在写入的文件，这些文件不压缩也不删除
+///
+class LogArchive
+{
+public:
+    struct Policy {
+        bool compress = true;
+        int maxFiles = 60;                         // 最多保留文件数（0不限）
+        int maxAgeDays = 30;                       // 最长保留天数（0不限）
+        qint64 maxTotalBytes = 1024LL * 1024 * 1024; // 目录总大小上限（0不限）
+    };
+
+    // 整理日志目录：压缩正在写入以外的日志文本，再按策略删除
+    static void housekeep(const QString& logDir, const Policy& policy);
+    // 创建整理任务（交给QThreadPool，执行后自动删除）
+    static QRunnable* createTask(const QString& logDir, const Policy& policy);
+    // 登记输出器正在写入的文件（owner为输出器，换文件时重新登记，传空列表注销）
+    static void setActiveFiles(const void* owner, const QStringList& files);
+
+    // 压缩为<filePath>.gz，成功后删除原文件
+    static bool compressFile(const QString& filePath, QString* errorMsg = nullptr);
+    // 数据编码为gzip格式（mtime为修改时间，秒）
+    static QByteArray gzip(const QByteArray& data, quint32 mtime = 0);
+    static quint32 crc32(const QByteArray& data);
+
+    // 日志文件名匹配（文本、压缩后的文本与结构化日志）
+    static QStringList nameFilters();
+};
+
+#endif // LOGARCHIVE_H
@@ -0,0 +1,94 @@
+﻿#ifndef LOGRINGBUFFER_H
+#define LOGRINGBUFFER_H
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+///
+/// \brief 有界无锁环形队列（Vyukov算法）
+/// 多个生产者并发tryPush，只允许一个消费者tryPop；每个槽位用序号标记“可写/可读”，
+/// 生产者只在入队位置上做一次CAS，消费者不需要CAS。容量按2的幂向上取整
+///
+template<typename T>
+class LogRingBuffer
+{
+public:
+    explicit LogRingBuffer(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        m_mask = size - 1;
+        m_cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        m_enqueuePos.store(0, std::memory_order_relaxed);
+        m_dequeuePos.store(0, std::memory_order_relaxed);
+    }
+    LogRingBuffer(const LogRingBuffer&) = delete;
+    LogRingBuffer& operator=(const LogRingBuffer&) = delete;
+
+    // 入队（任意线程）：成功时value被移走，队列满时返回false且value保持不变
+    bool tryPush(T& value)
+    {
+        Cell* cell = nullptr;
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &m_cells[pos & m_mask];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false; // 该槽位尚未被消费：队列已满
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 出队（仅消费者线程）：队列空时返回false
+    bool tryPop(T& value)
+    {
+        const size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Cell* cell = &m_cells[pos & m_mask];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1) < 0) return false;
+        m_dequeuePos.store(pos + 1, std::memory_order_relaxed);
+        value = std::move(cell->data);
+        cell->data = T(); // 及时释放槽位持有的内存
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 近似判断是否为空（仅消费者线程调用时准确）
+    bool isEmpty() const
+    {
+        const size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        const size_t sequence = m_cells[pos & m_mask].sequence.load(std::memory_order_acquire);
+        return static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1) < 0;
+    }
+
+    size_t capacity() const { return m_mask + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+    static const size_t CACHE_LINE = 64;
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask = 0;
+    // 入队/出队位置用填充隔开，分处不同缓存行，避免生产者与消费者互相失效（堆上分配不依赖alignas）
+    char m_padding0[CACHE_LINE];
+    std::atomic<size_t> m_enqueuePos;
+    char m_padding1[CACHE_LINE];
+    std::atomic<size_t> m_dequeuePos;
+};
+
+#endif // LOGRINGBUFFER_H
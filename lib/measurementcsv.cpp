@@ -0,0 +1,96 @@
+﻿#include "measurementcsv.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QRegularExpression>
+#include <QMap>
+
+MeasurementCsv::FileKey MeasurementCsv::parseFileName(const QString &fileName)
+{
+    FileKey key;
+    QStringList parts = QFileInfo(fileName).completeBaseName().split('_');
+    if (parts.size() < 2) return key;
+    const QString stamp = parts.at(1);
+    QDateTime measuredAt;
+    if (stamp.size() == 14) {
+        measuredAt = QDateTime::fromString(stamp, "yyyyMMddHHmmss");
+    } else if (stamp.size() == 8) {
+        measuredAt = QDateTime(QDate::fromString(stamp, "yyyyMMdd"), QTime(0, 0));
+    }
+    if (!measuredAt.isValid()) return key;
+    key.serialNo = parts.at(0).trimmed();
+    key.measuredAt = measuredAt;
+    key.judgeResult = parts.size() > 2 ? parts.at(2).trimmed().toUpper() : QString();
+    return key;
+}
+
+QList<DimReport::InspectionParam> MeasurementCsv::parse(const QString &filePath, QString *errorMsg)
+{
+    QList<DimReport::InspectionParam> paramList;
+    QFile csvFile(filePath);
+    if (!csvFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (errorMsg) *errorMsg = QString("无法打开CSV文件：%1").arg(filePath);
+        return paramList;
+    }
+
+    QTextStream in(&csvFile);
+    QStringList csvLines;
+    while (!in.atEnd() && csvLines.size() < 2) {
+        QString line = in.readLine().trimmed();
+        if (!line.isEmpty()) {
+            csvLines.append(line);
+        }
+    }
+    csvFile.close();
+
+    if (csvLines.size() < 2) {
+        if (errorMsg) *errorMsg = QString("CSV格式异常！仅读取到%1行，要求固定2行（表头+数据）").arg(csvLines.size());
+        return paramList;
+    }
+
+    QStringList headerColumns = csvLines[0].split(",");
+    QStringList dataColumns = csvLines[1].split(",");
+
+    static const QRegularExpression headerRegex("^([a-zA-Z]+)_(.*)$");
+    QMap<QString, QMap<QString, QString>> paramAttrMap; // 参数名→属性→单元格文本
+
+    for (int colIndex = 0; colIndex < headerColumns.size(); ++colIndex)
+    {
+        QString header = headerColumns[colIndex].trimmed();
+        QString data = (colIndex < dataColumns.size()) ? dataColumns[colIndex].trimmed() : "";
+
+        QRegularExpressionMatch match = headerRegex.match(header);
+        if (!match.hasMatch()) continue;
+
+        QString attrType = match.captured(1);
+        QString paramName = match.captured(2);
+        paramAttrMap[paramName][attrType] = data;
+    }
+
+    // 遍历属性Map，组装成InspectionParam
+    for (auto attrMapIt = paramAttrMap.constBegin(); attrMapIt != paramAttrMap.constEnd(); ++attrMapIt)
+    {
+        const QMap<QString, QString>& attrMap = attrMapIt.value();
+
+        DimReport::InspectionParam param;
+        param.name = attrMapIt.key();
+        param.defaultValue = toValue(attrMap.value("DefaultValue", ""));
+        param.maxValue = toValue(attrMap.value("Max", ""));
+        param.minValue = toValue(attrMap.value("Min", ""));
+        param.actualValue = toValue(attrMap.value("ActualValue", ""));
+        param.offset = toValue(attrMap.value("Offset", ""));
+        param.overOffset = toValue(attrMap.value("OverOffset", ""));
+
+        paramList.append(param);
+    }
+    return paramList;
+}
+
+QVariant MeasurementCsv::toValue(const QString &text)
+{
+    if (text.compare("N/A", Qt::CaseInsensitive) == 0) return QVariant("N/A");
+    bool isNumber;
+    double num = text.toDouble(&isNumber);
+    if (isNumber && qFuzzyCompare(num, 7777777.0)) return QVariant("无效值");
+    return text.isEmpty() ? QVariant("") : (isNumber ? QVariant(num) : QVariant(text));
+}
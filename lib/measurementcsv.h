@@ -0,0 +1,34 @@
+﻿#ifndef MEASUREMENTCSV_H
+#define MEASUREMENTCSV_H
+
+#include <QString>
+#include <QDateTime>
+#include <QList>
+#include <QVariant>
+#include "reporttool.h"
+
+///
+/// \brief 检测数据CSV解析
+/// 文件固定两行：表头行每列形如<属性>_<参数名>（属性：Name/DefaultValue/Max/Min/ActualValue/Offset/OverOffset），
+/// 数据行与表头逐列对应；文件名形如<产品序列号>_<yyyyMMdd[HHmmss]>[_<NG|OK>].csv
+///
+class MeasurementCsv
+{
+public:
+    // 由文件名得到的检测标识
+    struct FileKey {
+        QString serialNo;      // 产品序列号
+        QDateTime measuredAt;  // 检测时间（文件名只有日期时为当日0点）
+        QString judgeResult;   // 判定结果（NG/OK，可为空）
+        bool isValid() const { return !serialNo.isEmpty() && measuredAt.isValid(); }
+    };
+    static FileKey parseFileName(const QString& fileName);
+
+    // 解析检测参数（按参数名排序）；文件无法读取或格式异常时返回空列表并写入errorMsg
+    static QList<DimReport::InspectionParam> parse(const QString& filePath, QString* errorMsg = nullptr);
+
+    // 单元格文本转参数值：N/A原样保留，7777777视为无效值，数字转double
+    static QVariant toValue(const QString& text);
+};
+
+#endif // MEASUREMENTCSV_H
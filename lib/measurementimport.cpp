@@ -0,0 +1,288 @@
+﻿#include "measurementimport.h"
+#include "sqlservice.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <QFuture>
+#include <QtConcurrent/QtConcurrentRun>
+
+static const QString RECORD_TABLE = "measurement_record";
+static const QString FILE_TABLE = "measurement_file";
+static const QString DATETIME_FORMAT = "yyyy-MM-dd HH:mm:ss";
+
+bool MeasurementImporter::ensureSchema(QString *errorMsg)
+{
+    SqlService& sql = SqlService::Get();
+    QStringList ddl;
+    // 早期表结构的主键不含source_file，同一产品同一时刻的两个文件（只有日期的文件名、NG/OK各一份）会互相覆盖；
+    // 表中数据都能由CSV重新导入，删除后按新结构重建
+    SqlService::QueryResult columns = sql.GetData(sql.isMySql() ? QString("DESC %1").arg(RECORD_TABLE)
+                                                                : QString("PRAGMA table_info(%1)").arg(RECORD_TABLE));
+    if (columns.success && !columns.data.isEmpty()) {
+        bool keyedBySource = false;
+        for (const QVariantMap& column : columns.data) {
+            const bool primary = sql.isMySql() ? column.value("Key").toString() == "PRI" : column.value("pk").toInt() > 0;
+            if (primary && column.value(sql.isMySql() ? "Field" : "name").toString() == "source_file") {
+                keyedBySource = true;
+            }
+        }
+        if (!keyedBySource) {
+            ddl << QString("DROP TABLE IF EXISTS %1").arg(RECORD_TABLE)
+                << QString("DROP TABLE IF EXISTS %1").arg(FILE_TABLE);
+        }
+    }
+    if (sql.isMySql()) {
+        ddl << QString("CREATE TABLE IF NOT EXISTS %1 ("
+                       "product_serial_no VARCHAR(64) NOT NULL, measured_at DATETIME NOT NULL,"
+                       " param_name VARCHAR(128) NOT NULL, default_value VARCHAR(64), max_value VARCHAR(64),"
+                       " min_value VARCHAR(64), actual_value VARCHAR(64), actual_num DOUBLE NULL,"
+                       " offset_value VARCHAR(64), over_offset VARCHAR(64), judge_result VARCHAR(8),"
+                       " source_file VARCHAR(255) NOT NULL, import_time DATETIME NOT NULL,"
+                       " PRIMARY KEY (product_serial_no, measured_at, param_name, source_file),"
+                       " INDEX idx_measured_at (measured_at), INDEX idx_param_time (param_name, measured_at),"
+                       " INDEX idx_source_file (source_file))").arg(RECORD_TABLE)
+            << QString("CREATE TABLE IF NOT EXISTS %1 ("
+                       "source_file VARCHAR(255) NOT NULL PRIMARY KEY, file_size BIGINT NOT NULL,"
+                       " file_modified VARCHAR(32) NOT NULL, row_count INT NOT NULL, import_time DATETIME NOT NULL)")
+               .arg(FILE_TABLE);
+    } else {
+        ddl << QString("CREATE TABLE IF NOT EXISTS %1 ("
+                       "product_serial_no TEXT NOT NULL, measured_at TEXT NOT NULL, param_name TEXT NOT NULL,"
+                       " default_value TEXT, max_value TEXT, min_value TEXT, actual_value TEXT, actual_num REAL,"
+                       " offset_value TEXT, over_offset TEXT, judge_result TEXT, source_file TEXT NOT NULL,"
+                       " import_time TEXT NOT NULL, PRIMARY KEY (product_serial_no, measured_at, param_name, source_file))")
+               .arg(RECORD_TABLE)
+            << QString("CREATE INDEX IF NOT EXISTS idx_measured_at ON %1 (measured_at)").arg(RECORD_TABLE)
+            << QString("CREATE INDEX IF NOT EXISTS idx_param_time ON %1 (param_name, measured_at)").arg(RECORD_TABLE)
+            << QString("CREATE INDEX IF NOT EXISTS idx_source_file ON %1 (source_file)").arg(RECORD_TABLE)
+            << QString("CREATE TABLE IF NOT EXISTS %1 ("
+                       "source_file TEXT NOT NULL PRIMARY KEY, file_size INTEGER NOT NULL, file_modified TEXT NOT NULL,"
+                       " row_count INTEGER NOT NULL, import_time TEXT NOT NULL)").arg(FILE_TABLE);
+    }
+    for (const QString& statement : ddl) {
+        SqlService::QueryResult result = sql.NonQuery(statement);
+        if (!result.success) {
+            if (errorMsg) *errorMsg = result.errorMsg;
+            return false;
+        }
+    }
+    return true;
+}
+
+MeasurementImporter::Result MeasurementImporter::importDirectory(const QString &dirPath, const Options &options)
+{
+    Result result;
+    QElapsedTimer timer;
+    timer.start();
+    QDir dir(dirPath);
+    if (!dir.exists()) {
+        result.errorMsg = QString("Csv目录不存在：%1").arg(dirPath);
+        return result;
+    }
+    if (!ensureSchema(&result.errorMsg)) {
+        return result;
+    }
+    QHash<QString, FileStamp> imported;
+    if (!options.force) {
+        imported = loadImportedFiles(&result.errorMsg);
+        if (!result.errorMsg.isEmpty()) return result;
+    }
+
+    QStringList filePaths;
+    for (const QString& name : dir.entryList(QStringList() << "*.csv", QDir::Files, QDir::Name)) {
+        filePaths << dir.filePath(name);
+    }
+    result.totalFiles = filePaths.size();
+
+    // 分块交给线程池并行解析，按块顺序依次写入
+    const int filesPerChunk = qMax(1, options.filesPerChunk);
+    const SqlCancelTokenPtr cancel = options.cancel;
+    QList<QFuture<ParsedChunk>> futures;
+    for (int start = 0; start < filePaths.size(); start += filesPerChunk) {
+        QStringList chunk = filePaths.mid(start, filesPerChunk);
+        const bool force = options.force;
+        futures << QtConcurrent::run([chunk, &imported, force, cancel]() {
+            return parseChunk(chunk, imported, force, cancel);
+        });
+    }
+    for (QFuture<ParsedChunk>& future : futures) {
+        // 取消后仍等待各块解析返回（在文件之间停止），但不再写入
+        future.waitForFinished();
+        if (cancel && cancel->isCancelled()) {
+            result.cancelled = true;
+            continue;
+        }
+        ParsedChunk chunk = future.result();
+        // 写入后不再保留该块的解析结果
+        future = QFuture<ParsedChunk>();
+        result.skippedFiles += chunk.skippedFiles;
+        result.failures << chunk.failures;
+        if (chunk.fileNames.isEmpty()) continue;
+        const QString writeError = writeChunk(chunk);
+        if (!writeError.isEmpty()) {
+            for (const QString& fileName : chunk.fileNames) {
+                result.failures << QString("%1：%2").arg(fileName).arg(writeError);
+            }
+            continue;
+        }
+        result.importedFiles += chunk.fileNames.size();
+        result.rows += chunk.rows;
+    }
+    result.failedFiles = result.failures.size();
+    result.success = result.failedFiles == 0 && !result.cancelled;
+    if (result.cancelled) {
+        result.errorMsg = "导入已取消";
+    } else if (!result.success) {
+        result.errorMsg = QString("%1个文件导入失败").arg(result.failedFiles);
+    }
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
+
+MeasurementImporter::FileStamp MeasurementImporter::stampOf(const QFileInfo &info)
+{
+    FileStamp stamp;
+    stamp.size = info.size();
+    stamp.modified = info.lastModified().toString(Qt::ISODate);
+    return stamp;
+}
+
+QHash<QString, MeasurementImporter::FileStamp> MeasurementImporter::loadImportedFiles(QString *errorMsg)
+{
+    QHash<QString, FileStamp> stamps;
+    SqlService::QueryResult result = SqlService::Get().GetData(
+                QString("SELECT source_file, file_size, file_modified FROM %1").arg(FILE_TABLE));
+    if (!result.success) {
+        if (errorMsg) *errorMsg = result.errorMsg;
+        return stamps;
+    }
+    for (const QVariantMap& row : result.data) {
+        FileStamp stamp;
+        stamp.size = row.value("file_size").toLongLong();
+        stamp.modified = row.value("file_modified").toString();
+        stamps.insert(row.value("source_file").toString(), stamp);
+    }
+    return stamps;
+}
+
+MeasurementImporter::ParsedChunk MeasurementImporter::parseChunk(const QStringList &filePaths,
+                                                                 const QHash<QString, FileStamp> &imported, bool force,
+                                                                 const SqlCancelTokenPtr &cancel)
+{
+    ParsedChunk chunk;
+    const QString importTime = QDateTime::currentDateTime().toString(DATETIME_FORMAT);
+
+    for (const QString& filePath : filePaths) {
+        if (cancel && cancel->isCancelled()) break;
+        QFileInfo info(filePath);
+        const QString fileName = info.fileName();
+        const FileStamp stamp = stampOf(info);
+        auto it = imported.constFind(fileName);
+        const bool known = it != imported.constEnd();
+        if (!force && known && it->size == stamp.size && it->modified == stamp.modified) {
+            ++chunk.skippedFiles;
+            continue;
+        }
+
+        MeasurementCsv::FileKey key = MeasurementCsv::parseFileName(fileName);
+        if (!key.isValid()) {
+            chunk.failures << QString("%1：文件名中缺少产品序列号或检测时间").arg(fileName);
+            continue;
+        }
+        QString errorMsg;
+        QList<DimReport::InspectionParam> params = MeasurementCsv::parse(filePath, &errorMsg);
+        if (params.isEmpty()) {
+            chunk.failures << QString("%1：%2").arg(fileName).arg(errorMsg.isEmpty() ? "没有有效的检测参数" : errorMsg);
+            continue;
+        }
+
+        // 文件内容变化：先删除该文件之前写入的行，避免残留已不存在的参数
+        if (known || force) {
+            chunk.staleFiles << QVariantList{fileName};
+        }
+        const QString measuredAt = key.measuredAt.toString(DATETIME_FORMAT);
+        for (const DimReport::InspectionParam& param : params) {
+            QVariant actualNum = param.actualValue.type() == QVariant::Double ? param.actualValue
+                                                                               : QVariant(QVariant::Double);
+            chunk.recordRows << QVariantList{
+                key.serialNo, measuredAt, param.name,
+                param.defaultValue.toString(), param.maxValue.toString(), param.minValue.toString(),
+                param.actualValue.toString(), actualNum,
+                param.offset.toString(), param.overOffset.toString(),
+                key.judgeResult, fileName, importTime
+            };
+        }
+        chunk.fileRows << QVariantList{fileName, stamp.size, stamp.modified, params.size(), importTime};
+        chunk.fileNames << fileName;
+        chunk.rows += params.size();
+    }
+    return chunk;
+}
+
+QString MeasurementImporter::writeChunk(const ParsedChunk &chunk)
+{
+    // 先写参数行，最后写文件指纹：中途失败时下次会重新导入
+    SqlService& sql = SqlService::Get();
+    SqlService::BatchResult batch;
+    batch.success = true;
+    if (!chunk.staleFiles.isEmpty()) {
+        batch = sql.BatchExec(QString("DELETE FROM %1 WHERE source_file = ?").arg(RECORD_TABLE), chunk.staleFiles);
+    }
+    if (batch.success) {
+        batch = sql.BatchUpsert(RECORD_TABLE, {
+                                    "product_serial_no", "measured_at", "param_name",
+                                    "default_value", "max_value", "min_value",
+                                    "actual_value", "actual_num", "offset_value", "over_offset",
+                                    "judge_result", "source_file", "import_time"
+                                }, chunk.recordRows);
+    }
+    if (batch.success) {
+        batch = sql.BatchUpsert(FILE_TABLE, {"source_file", "file_size", "file_modified", "row_count", "import_time"},
+                                chunk.fileRows);
+    }
+    return batch.success ? QString() : batch.errorMsg;
+}
+
+QList<DimReport::InspectionParam> MeasurementImporter::loadParams(const QString &filePath, QString *errorMsg)
+{
+    QList<DimReport::InspectionParam> params;
+    QFileInfo info(filePath);
+    const QString fileName = info.fileName();
+    SqlService& sql = SqlService::Get();
+    // 只信任与磁盘文件指纹一致的导入结果
+    SqlService::QueryResult stampResult = sql.GetData(
+                QString("SELECT file_size, file_modified FROM %1 WHERE source_file = ?").arg(FILE_TABLE),
+                QList<QVariant>() << fileName);
+    if (errorMsg) *errorMsg = stampResult.errorMsg;
+    if (!stampResult.success || stampResult.data.isEmpty()) return params;
+    const QVariantMap& stampRow = stampResult.data.first();
+    const FileStamp stamp = stampOf(info);
+    if (stampRow.value("file_size").toLongLong() != stamp.size
+            || stampRow.value("file_modified").toString() != stamp.modified) {
+        return params;
+    }
+
+    SqlService::QueryResult result = sql.GetData(
+                QString("SELECT param_name, default_value, max_value, min_value, actual_value, offset_value, over_offset "
+                        "FROM %1 WHERE source_file = ?").arg(RECORD_TABLE),
+                QList<QVariant>() << fileName);
+    if (errorMsg) *errorMsg = result.errorMsg;
+    if (!result.success) return params;
+    for (const QVariantMap& row : result.data) {
+        DimReport::InspectionParam param;
+        param.name = row.value("param_name").toString();
+        param.defaultValue = MeasurementCsv::toValue(row.value("default_value").toString());
+        param.maxValue = MeasurementCsv::toValue(row.value("max_value").toString());
+        param.minValue = MeasurementCsv::toValue(row.value("min_value").toString());
+        param.actualValue = MeasurementCsv::toValue(row.value("actual_value").toString());
+        param.offset = MeasurementCsv::toValue(row.value("offset_value").toString());
+        param.overOffset = MeasurementCsv::toValue(row.value("over_offset").toString());
+        params.append(param);
+    }
+    // 数据库排序规则可能与QString不同，按解析CSV时的顺序重新排列
+    std::sort(params.begin(), params.end(), [](const DimReport::InspectionParam& a, const DimReport::InspectionParam& b) {
+        return a.name < b.name;
+    });
+    return params;
+}
@@ -0,0 +1,72 @@
+﻿#ifndef MEASUREMENTIMPORT_H
+#define MEASUREMENTIMPORT_H
+
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+#include <QHash>
+#include <QFileInfo>
+#include "measurementcsv.h"
+#include "sqlservice.h"
+
+///
+/// \brief 检测数据入库
+/// measurement_record按(产品序列号, 检测时间, 参数名, 来源文件)存储每个尺寸参数；measurement_file记录已导入文件的大小与修改时间，
+/// 再次导入时跳过未变化的文件，变化的文件先删除旧行再写入，因此可重复执行。
+/// 文件按块分给线程池并行解析，解析结果在调用线程中按块依次写入（SqlService的语句执行是串行的，并行写入只会互相等锁）
+///
+class MeasurementImporter
+{
+public:
+    struct Options {
+        int filesPerChunk = 32;  // 每块文件数
+        bool force = false;      // 忽略导入记录，全部重新导入
+        SqlCancelTokenPtr cancel; // 取消令牌（可为空）：解析在文件之间、写入在分块之间检查
+    };
+
+    struct Result {
+        bool success = false;
+        bool cancelled = false;  // 已取消（已写入的分块保留，下次导入时跳过）
+        QString errorMsg;
+        int totalFiles = 0;
+        int importedFiles = 0;
+        int skippedFiles = 0;    // 已导入且未变化
+        int failedFiles = 0;
+        int rows = 0;            // 写入的参数行数
+        qint64 elapsedMs = 0;
+        QStringList failures;    // 失败文件及原因
+    };
+
+    // 建表（已存在时跳过）
+    static bool ensureSchema(QString* errorMsg = nullptr);
+    // 导入目录下全部CSV
+    static Result importDirectory(const QString& dirPath, const Options& options = Options());
+    // 从库中读取CSV文件导入的全部参数（按参数名排序，与MeasurementCsv::parse一致）；
+    // 文件未导入或导入后又被修改时返回空列表，调用方改为直接解析文件
+    static QList<DimReport::InspectionParam> loadParams(const QString& filePath, QString* errorMsg = nullptr);
+
+private:
+    // 已导入文件的指纹
+    struct FileStamp {
+        qint64 size = 0;
+        QString modified;
+    };
+    // 一块文件的解析结果（待写入的行）
+    struct ParsedChunk {
+        int skippedFiles = 0;
+        int rows = 0;
+        QStringList failures;
+        QList<QVariantList> recordRows;
+        QList<QVariantList> fileRows;
+        QList<QVariantList> staleFiles;
+        QStringList fileNames;
+    };
+    static FileStamp stampOf(const QFileInfo& info);
+    static QHash<QString, FileStamp> loadImportedFiles(QString* errorMsg);
+    static ParsedChunk parseChunk(const QStringList& filePaths, const QHash<QString, FileStamp>& imported, bool force,
+                                  const SqlCancelTokenPtr& cancel);
+    // 写入一块的解析结果，失败时返回原因
+    static QString writeChunk(const ParsedChunk& chunk);
+};
+
+#endif // MEASUREMENTIMPORT_H
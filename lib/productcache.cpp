@@ -0,0 +1,247 @@
+﻿#include "productcache.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QDateTime>
+
+static const QString META_WATERMARK_TIME = "watermark_change_time";
+static const QString META_WATERMARK_ID = "watermark_product_id";
+// 每次同步后复查水位之前的秒数：事务提交顺序与变更时间不一致时，补上晚提交但时间更早的行
+static const int WATERMARK_OVERLAP_SECS = 5;
+
+// 游标a是否在b之后（按(变更时间, 主键)比较）
+static bool cursorAfter(const SqlService::DeltaCursor& a, const SqlService::DeltaCursor& b)
+{
+    const QDateTime timeA = a.changeTime.toDateTime();
+    const QDateTime timeB = b.changeTime.toDateTime();
+    return timeA != timeB ? timeA > timeB : a.key > b.key;
+}
+
+// 记录在本地缓存中保存的JSON
+static QByteArray recordJson(const QVariantMap& record)
+{
+    return QJsonDocument(QJsonObject::fromVariantMap(record)).toJson(QJsonDocument::Compact);
+}
+
+ProductLocalCache::ProductLocalCache(const QString &filePath)
+    : m_filePath(filePath.isEmpty() ? defaultFilePath() : filePath)
+{
+    m_connName = QString("PRODUCT_CACHE_%1").arg(reinterpret_cast<quintptr>(this), 0, 16);
+}
+
+ProductLocalCache::~ProductLocalCache()
+{
+    close();
+}
+
+QString ProductLocalCache::defaultFilePath()
+{
+    return QDir(QCoreApplication::applicationDirPath()).filePath("product_cache.db");
+}
+
+bool ProductLocalCache::open(QString *errorMsg)
+{
+    if (m_db.isOpen()) return true;
+    m_db = QSqlDatabase::addDatabase("QSQLITE", m_connName);
+    m_db.setDatabaseName(m_filePath);
+    if (!m_db.open()) {
+        if (errorMsg) *errorMsg = m_db.lastError().text();
+        return false;
+    }
+    QSqlQuery query(m_db);
+    // WAL：后台同步写入时界面线程仍可读取
+    query.exec("PRAGMA journal_mode=WAL");
+    query.exec("PRAGMA synchronous=NORMAL");
+    const QStringList ddl = {
+        "CREATE TABLE IF NOT EXISTS product_record ("
+        " product_id INTEGER PRIMARY KEY,"
+        " job_order_no TEXT NOT NULL,"
+        " create_time TEXT NOT NULL,"
+        " record_json TEXT NOT NULL)",
+        "CREATE INDEX IF NOT EXISTS idx_product_record_time ON product_record(create_time, product_id)",
+        "CREATE TABLE IF NOT EXISTS sync_meta (meta_key TEXT PRIMARY KEY, meta_value TEXT)"
+    };
+    for (const QString& sql : ddl) {
+        if (!query.exec(sql)) {
+            if (errorMsg) *errorMsg = query.lastError().text();
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ProductLocalCache::close()
+{
+    if (!QSqlDatabase::contains(m_connName)) return;
+    if (m_db.isOpen()) m_db.close();
+    m_db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(m_connName);
+}
+
+QList<QVariantMap> ProductLocalCache::loadAll(QString *errorMsg)
+{
+    QList<QVariantMap> records;
+    QSqlQuery query(m_db);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT record_json FROM product_record ORDER BY create_time ASC, product_id ASC")) {
+        if (errorMsg) *errorMsg = query.lastError().text();
+        return records;
+    }
+    while (query.next()) {
+        records.append(QJsonDocument::fromJson(query.value(0).toByteArray()).object().toVariantMap());
+    }
+    return records;
+}
+
+SqlService::DeltaCursor ProductLocalCache::watermark()
+{
+    SqlService::DeltaCursor cursor;
+    QDateTime time = QDateTime::fromString(meta(META_WATERMARK_TIME), Qt::ISODateWithMs);
+    if (time.isValid()) {
+        cursor.changeTime = time;
+        cursor.key = meta(META_WATERMARK_ID).toLongLong();
+    }
+    return cursor;
+}
+
+bool ProductLocalCache::upsert(const QList<QVariantMap> &records, const SqlService::DeltaCursor &newWatermark, QString *errorMsg)
+{
+    if (!m_db.transaction()) {
+        if (errorMsg) *errorMsg = m_db.lastError().text();
+        return false;
+    }
+    QSqlQuery query(m_db);
+    query.prepare("INSERT OR REPLACE INTO product_record (product_id, job_order_no, create_time, record_json) "
+                  "VALUES (?, ?, ?, ?)");
+    QVariantList ids, jobOrders, times, jsons;
+    for (const QVariantMap& record : records) {
+        ids << record.value("product_id");
+        jobOrders << record.value("job_order_no").toString().trimmed();
+        times << record.value("create_time").toString();
+        jsons << recordJson(record);
+    }
+    query.addBindValue(ids);
+    query.addBindValue(jobOrders);
+    query.addBindValue(times);
+    query.addBindValue(jsons);
+    bool ok = records.isEmpty() || query.execBatch();
+    if (ok && !newWatermark.isStart()) {
+        ok = setMeta(META_WATERMARK_TIME, newWatermark.changeTime.toDateTime().toString(Qt::ISODateWithMs))
+                && setMeta(META_WATERMARK_ID, QString::number(newWatermark.key));
+    }
+    if (!ok || !m_db.commit()) {
+        if (errorMsg) *errorMsg = query.lastError().text().isEmpty() ? m_db.lastError().text() : query.lastError().text();
+        m_db.rollback();
+        return false;
+    }
+    return true;
+}
+
+ProductLocalCache::LoadResult ProductLocalCache::loadFromFile(const QString &filePath)
+{
+    LoadResult result;
+    QElapsedTimer timer;
+    timer.start();
+    ProductLocalCache cache(filePath);
+    if (!cache.open(&result.errorMsg)) {
+        return result;
+    }
+    result.opened = true;
+    result.records = cache.loadAll(&result.errorMsg);
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
+
+ProductLocalCache::SyncResult ProductLocalCache::syncFromServer(const QString &filePath, int pageSize,
+                                                                const SqlCancelTokenPtr &cancel)
+{
+    SyncResult result;
+    QElapsedTimer timer;
+    timer.start();
+    ProductLocalCache cache(filePath);
+    if (!cache.open(&result.errorMsg)) {
+        return result;
+    }
+    // 按水位分页拉取新增/修改的记录，直到没有更新的记录
+    const SqlService::DeltaCursor watermark = cache.watermark();
+    SqlService::DeltaCursor cursor = watermark;
+    while (true) {
+        SqlService::QueryResult page = ProductQuery::fetchChangedRecords(cursor, pageSize, cancel);
+        if (!page.success) {
+            result.errorMsg = page.errorMsg;
+            return result;
+        }
+        if (page.data.isEmpty()) break;
+        if (!cache.upsert(page.data, cursor, &result.errorMsg)) {
+            return result;
+        }
+        result.records.append(page.data);
+        if (page.data.size() < pageSize) break;
+    }
+    // 复查原水位之前的一段时间：只保留与缓存内容不同的行，水位不变
+    if (!watermark.isStart()) {
+        SqlService::DeltaCursor overlap;
+        overlap.changeTime = watermark.changeTime.toDateTime().addSecs(-WATERMARK_OVERLAP_SECS);
+        while (true) {
+            SqlService::QueryResult page = ProductQuery::fetchChangedRecords(overlap, pageSize, cancel);
+            if (!page.success) {
+                result.errorMsg = page.errorMsg;
+                return result;
+            }
+            const QList<QVariantMap> changed = cache.changedRecords(page.data);
+            if (!changed.isEmpty()) {
+                if (!cache.upsert(changed, SqlService::DeltaCursor(), &result.errorMsg)) {
+                    return result;
+                }
+                result.records.append(changed);
+            }
+            if (page.data.size() < pageSize || cursorAfter(overlap, watermark)) break;
+        }
+    }
+    if (!result.records.isEmpty()) {
+        ProductQuery::invalidateCache();
+    }
+    result.success = true;
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
+
+bool ProductLocalCache::setMeta(const QString &key, const QString &value)
+{
+    QSqlQuery query(m_db);
+    query.prepare("INSERT OR REPLACE INTO sync_meta (meta_key, meta_value) VALUES (?, ?)");
+    query.addBindValue(key);
+    query.addBindValue(value);
+    return query.exec();
+}
+
+QList<QVariantMap> ProductLocalCache::changedRecords(const QList<QVariantMap> &records)
+{
+    QList<QVariantMap> changed;
+    QSqlQuery query(m_db);
+    query.prepare("SELECT record_json FROM product_record WHERE product_id = ?");
+    for (const QVariantMap& record : records) {
+        query.addBindValue(record.value("product_id"));
+        if (!query.exec() || !query.next() || query.value(0).toByteArray() != recordJson(record)) {
+            changed.append(record);
+        }
+        query.finish();
+    }
+    return changed;
+}
+
+QString ProductLocalCache::meta(const QString &key)
+{
+    QSqlQuery query(m_db);
+    query.prepare("SELECT meta_value FROM sync_meta WHERE meta_key = ?");
+    query.addBindValue(key);
+    if (query.exec() && query.next()) {
+        return query.value(0).toString();
+    }
+    return QString();
+}
@@ -0,0 +1,75 @@
+﻿#ifndef PRODUCTCACHE_H
+#define PRODUCTCACHE_H
+
+#include <QString>
+#include <QList>
+#include <QVariantMap>
+#include <QSqlDatabase>
+#include "productquery.h"
+
+///
+/// \brief 产品记录本地缓存（SQLite，默认位于config.ini同目录product_cache.db）
+/// 保存完整产品记录与同步水位(变更时间, product_id)，启动时无需数据库即可显示；
+/// QSqlDatabase不能跨线程使用，每个线程各自构造实例
+///
+class ProductLocalCache
+{
+public:
+    explicit ProductLocalCache(const QString& filePath = QString());
+    ~ProductLocalCache();
+    ProductLocalCache(const ProductLocalCache&) = delete;
+    ProductLocalCache& operator=(const ProductLocalCache&) = delete;
+
+    // 打开缓存文件并建表
+    bool open(QString* errorMsg = nullptr);
+    void close();
+    bool isOpen() const { return m_db.isOpen(); }
+    QString filePath() const { return m_filePath; }
+
+    // 读取全部记录（按create_time, product_id升序）
+    QList<QVariantMap> loadAll(QString* errorMsg = nullptr);
+    // 上次同步到的水位（未同步过时isStart()为true）
+    SqlService::DeltaCursor watermark();
+    // 写入/覆盖记录并推进水位（同一事务）
+    bool upsert(const QList<QVariantMap>& records, const SqlService::DeltaCursor& newWatermark,
+                QString* errorMsg = nullptr);
+    // 与本地缓存内容不同（或尚未缓存）的记录
+    QList<QVariantMap> changedRecords(const QList<QVariantMap>& records);
+
+    // 后台加载结果
+    struct LoadResult {
+        bool opened = false;         // 缓存文件可用
+        QString errorMsg;
+        QList<QVariantMap> records;  // 全部记录（按create_time, product_id升序）
+        qint64 elapsedMs = 0;
+    };
+    // 打开缓存文件并读取全部记录（在工作线程调用，JSON解析不占用界面线程）
+    static LoadResult loadFromFile(const QString& filePath = QString());
+
+    // 后台增量同步结果
+    struct SyncResult {
+        bool success = false;
+        QString errorMsg;
+        QList<QVariantMap> records;  // 本次新增或修改的记录（按变更时间升序）
+        qint64 elapsedMs = 0;
+    };
+    // 从服务器拉取水位之后新增/修改的记录写入本地缓存（在工作线程调用，使用该线程独立连接），
+    // 再复查水位前WATERMARK_OVERLAP_SECS秒内晚提交的修改；有变化时淘汰产品表的查询缓存；
+    // cancel被取消时终止正在执行的查询并返回失败，已写入的页保留
+    static SyncResult syncFromServer(const QString& filePath = QString(), int pageSize = 1000,
+                                     const SqlCancelTokenPtr& cancel = SqlCancelTokenPtr());
+
+    // 默认缓存文件路径
+    static QString defaultFilePath();
+
+private:
+    bool setMeta(const QString& key, const QString& value);
+    QString meta(const QString& key);
+
+private:
+    QString m_filePath;
+    QString m_connName;
+    QSqlDatabase m_db;
+};
+
+#endif // PRODUCTCACHE_H
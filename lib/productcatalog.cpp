@@ -0,0 +1,334 @@
+﻿#include "productcatalog.h"
+#include <QSet>
+#include <algorithm>
+#include <initializer_list>
+
+// 哈希桶最小容量（2的幂）
+static const int MIN_BUCKETS = 16;
+
+// 满足装载因子不超过3/4的最小桶容量
+static int bucketCapacityFor(int count)
+{
+    int capacity = MIN_BUCKETS;
+    while (capacity * 3 < count * 4) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+ProductInfo ProductInfo::fromRecord(const QVariantMap &record)
+{
+    ProductInfo info;
+    info.productId = record.value("product_id").toLongLong();
+    info.productName = record.value("product_name").toString();
+    info.jobOrderNo = record.value("job_order_no").toString().trimmed();
+    info.materialGrade = record.value("material_grade").toString();
+    info.customerPo = record.value("customer_po").toString();
+    info.partNo = record.value("part_no").toString();
+    info.productSerialNo = record.value("product_serial_no").toString().trimmed();
+    info.drawingNo = record.value("drawing_no").toString();
+    info.partDescription = record.value("part_description").toString();
+    info.smeltingFurnaceNo = record.value("smelting_furnace_no").toString();
+    info.heatTreatmentFurnaceNo = record.value("heat_treatment_furnace_no").toString();
+    info.heatTreatmentState = record.value("heat_treatment_state").toString();
+    info.clientName = record.value("client_name").toString();
+    info.quantity = record.value("quantity").toInt();
+    info.reviewerResult = record.value("reviewer_result").toString();
+    info.toolName = record.value("tool_name").toString();
+    info.toolNo = record.value("tool_no").toString();
+    info.editorName = record.value("editor_name").toString();
+    info.editorOpinion = record.value("editor_opinion").toString();
+    info.reviewerName = record.value("reviewer_name").toString();
+    info.reviewerOpinion = record.value("reviewer_opinion").toString();
+    info.detectionStandardCode = record.value("detection_standard_code").toString();
+    info.acceptanceStandardCode = record.value("acceptance_standard_code").toString();
+    info.createTime = record.value("create_time").toString();
+    return info;
+}
+
+QVariantMap ProductInfo::toRecord() const
+{
+    QVariantMap record;
+    record.insert("product_id", productId);
+    record.insert("product_name", productName);
+    record.insert("job_order_no", jobOrderNo);
+    record.insert("material_grade", materialGrade);
+    record.insert("customer_po", customerPo);
+    record.insert("part_no", partNo);
+    record.insert("product_serial_no", productSerialNo);
+    record.insert("drawing_no", drawingNo);
+    record.insert("part_description", partDescription);
+    record.insert("smelting_furnace_no", smeltingFurnaceNo);
+    record.insert("heat_treatment_furnace_no", heatTreatmentFurnaceNo);
+    record.insert("heat_treatment_state", heatTreatmentState);
+    record.insert("client_name", clientName);
+    record.insert("quantity", quantity);
+    record.insert("reviewer_result", reviewerResult);
+    record.insert("tool_name", toolName);
+    record.insert("tool_no", toolNo);
+    record.insert("editor_name", editorName);
+    record.insert("editor_opinion", editorOpinion);
+    record.insert("reviewer_name", reviewerName);
+    record.insert("reviewer_opinion", reviewerOpinion);
+    record.insert("detection_standard_code", detectionStandardCode);
+    record.insert("acceptance_standard_code", acceptanceStandardCode);
+    record.insert("create_time", createTime);
+    return record;
+}
+
+// ---------------- StringIndex ----------------
+
+int ProductCatalog::StringIndex::find(const QString &key, const std::vector<ProductInfo> &products) const
+{
+    if (m_buckets.empty()) return -1;
+    int bucket = findBucket(key, qHash(key), products);
+    return bucket < 0 ? -1 : m_buckets[bucket].slot;
+}
+
+int ProductCatalog::StringIndex::findBucket(const QString &key, uint hash, const std::vector<ProductInfo> &products) const
+{
+    const int mask = int(m_buckets.size()) - 1;
+    // 装载因子不超过3/4，探测必然遇到空桶
+    for (int i = int(hash) & mask; ; i = (i + 1) & mask) {
+        const Bucket& bucket = m_buckets[i];
+        if (bucket.slot == EMPTY) return -1;
+        if (bucket.slot >= 0 && bucket.hash == hash && products[bucket.slot].*m_field == key) return i;
+    }
+}
+
+void ProductCatalog::StringIndex::insert(const QString &key, int slot, const std::vector<ProductInfo> &products)
+{
+    if ((m_count + m_deleted + 1) * 4 > int(m_buckets.size()) * 3) {
+        // 扩容（删除标记较多时同容量重建即可清理）
+        rehash(bucketCapacityFor(qMax(m_count * 2, MIN_BUCKETS)));
+    }
+    const uint hash = qHash(key);
+    const int mask = int(m_buckets.size()) - 1;
+    int firstDeleted = -1;
+    for (int i = int(hash) & mask; ; i = (i + 1) & mask) {
+        Bucket& bucket = m_buckets[i];
+        if (bucket.slot == EMPTY) {
+            int target = i;
+            if (firstDeleted >= 0) {
+                target = firstDeleted;
+                --m_deleted;
+            }
+            m_buckets[target].hash = hash;
+            m_buckets[target].slot = slot;
+            ++m_count;
+            return;
+        }
+        if (bucket.slot == DELETED) {
+            if (firstDeleted < 0) firstDeleted = i;
+        } else if (bucket.hash == hash && products[bucket.slot].*m_field == key) {
+            bucket.slot = slot;
+            return;
+        }
+    }
+}
+
+void ProductCatalog::StringIndex::remove(const QString &key, const std::vector<ProductInfo> &products)
+{
+    if (m_buckets.empty()) return;
+    int bucket = findBucket(key, qHash(key), products);
+    if (bucket < 0) return;
+    m_buckets[bucket].slot = DELETED;
+    --m_count;
+    ++m_deleted;
+}
+
+void ProductCatalog::StringIndex::clear()
+{
+    m_buckets.clear();
+    m_count = 0;
+    m_deleted = 0;
+}
+
+void ProductCatalog::StringIndex::reserve(int count)
+{
+    int capacity = bucketCapacityFor(count);
+    if (capacity > int(m_buckets.size())) {
+        rehash(capacity);
+    }
+}
+
+void ProductCatalog::StringIndex::rehash(int capacity)
+{
+    std::vector<Bucket> old;
+    old.swap(m_buckets);
+    m_buckets.resize(capacity);
+    const int mask = capacity - 1;
+    for (const Bucket& bucket : old) {
+        if (bucket.slot < 0) continue;
+        int i = int(bucket.hash) & mask;
+        while (m_buckets[i].slot != EMPTY) {
+            i = (i + 1) & mask;
+        }
+        m_buckets[i] = bucket;
+    }
+    m_deleted = 0;
+}
+
+// ---------------- ProductCatalog ----------------
+
+ProductCatalog::ProductCatalog()
+    : m_byJobOrder(&ProductInfo::jobOrderNo)
+    , m_bySerialNo(&ProductInfo::productSerialNo)
+{
+}
+
+void ProductCatalog::clear()
+{
+    m_products.clear();
+    m_freeSlots.clear();
+    m_byId.clear();
+    m_byJobOrder.clear();
+    m_bySerialNo.clear();
+    m_orderedJobOrders.clear();
+    m_orderDirty = false;
+}
+
+void ProductCatalog::reserve(int count)
+{
+    m_products.reserve(count);
+    m_byId.reserve(count);
+    m_byJobOrder.reserve(count);
+    m_bySerialNo.reserve(count);
+}
+
+void ProductCatalog::upsert(const ProductInfo &info)
+{
+    if (!info.isValid()) return;
+    int slot = m_byId.value(info.productId, -1);
+    if (slot >= 0) {
+        // 先按旧键移出索引，再覆盖记录
+        unindexSlot(slot, &info);
+        m_products[slot] = info;
+    } else if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        m_products[slot] = info;
+        m_byId.insert(info.productId, slot);
+    } else {
+        slot = int(m_products.size());
+        m_products.push_back(info);
+        m_byId.insert(info.productId, slot);
+    }
+    indexSlot(slot);
+    m_orderDirty = true;
+}
+
+void ProductCatalog::remove(qint64 productId)
+{
+    int slot = m_byId.value(productId, -1);
+    if (slot < 0) return;
+    unindexSlot(slot, nullptr);
+    m_products[slot] = ProductInfo();
+    m_freeSlots.push_back(slot);
+    m_byId.remove(productId);
+    m_orderDirty = true;
+}
+
+const ProductInfo *ProductCatalog::findById(qint64 productId) const
+{
+    int slot = m_byId.value(productId, -1);
+    return slot < 0 ? nullptr : &m_products[slot];
+}
+
+const ProductInfo *ProductCatalog::findByJobOrder(const QString &jobOrderNo) const
+{
+    int slot = m_byJobOrder.find(jobOrderNo, m_products);
+    return slot < 0 ? nullptr : &m_products[slot];
+}
+
+const ProductInfo *ProductCatalog::findBySerialNo(const QString &serialNo) const
+{
+    int slot = m_bySerialNo.find(serialNo, m_products);
+    return slot < 0 ? nullptr : &m_products[slot];
+}
+
+QStringList ProductCatalog::jobOrdersWithPrefix(const QString &prefix, int limit) const
+{
+    if (m_orderDirty) {
+        // 按(create_time, product_id)升序排列槽位，同一工作令号保留最早出现的位置
+        std::vector<int> slots;
+        slots.reserve(m_byId.size());
+        for (int i = 0; i < int(m_products.size()); ++i) {
+            if (m_products[i].isValid() && !m_products[i].jobOrderNo.isEmpty()) {
+                slots.push_back(i);
+            }
+        }
+        std::sort(slots.begin(), slots.end(), [this](int a, int b) { return preferOver(b, a); });
+        QSet<QString> seen;
+        seen.reserve(int(slots.size()));
+        m_orderedJobOrders.clear();
+        m_orderedJobOrders.reserve(int(slots.size()));
+        for (int slot : slots) {
+            const QString& jobOrderNo = m_products[slot].jobOrderNo;
+            if (!seen.contains(jobOrderNo)) {
+                seen.insert(jobOrderNo);
+                m_orderedJobOrders.append(jobOrderNo);
+            }
+        }
+        m_orderDirty = false;
+    }
+    QStringList result;
+    for (const QString& jobOrderNo : m_orderedJobOrders) {
+        if (result.size() >= limit) break;
+        if (jobOrderNo.startsWith(prefix)) {
+            result.append(jobOrderNo);
+        }
+    }
+    return result;
+}
+
+bool ProductCatalog::preferOver(int slot, int existing) const
+{
+    const ProductInfo& a = m_products[slot];
+    const ProductInfo& b = m_products[existing];
+    if (a.createTime != b.createTime) {
+        return a.createTime > b.createTime;
+    }
+    return a.productId > b.productId;
+}
+
+void ProductCatalog::indexSlot(int slot)
+{
+    for (StringIndex* index : {&m_byJobOrder, &m_bySerialNo}) {
+        const QString& key = m_products[slot].*(index->field());
+        if (key.isEmpty()) continue;
+        int existing = index->find(key, m_products);
+        if (existing < 0 || existing == slot || preferOver(slot, existing)) {
+            index->insert(key, slot, m_products);
+        }
+    }
+}
+
+void ProductCatalog::unindexSlot(int slot, const ProductInfo *next)
+{
+    for (StringIndex* index : {&m_byJobOrder, &m_bySerialNo}) {
+        const QString key = m_products[slot].*(index->field());
+        // 键未变化且创建时间未提前时保留索引，否则重新选出指向
+        if (key.isEmpty() || (next && next->*(index->field()) == key
+                              && next->createTime >= m_products[slot].createTime)) continue;
+        if (index->find(key, m_products) == slot) {
+            index->remove(key, m_products);
+            reindexKey(*index, key, slot);
+        }
+    }
+}
+
+void ProductCatalog::reindexKey(StringIndex &index, const QString &key, int excludeSlot)
+{
+    // 只在工作令号/序列号被修改或产品被删除时发生，线性扫描即可
+    int best = -1;
+    for (int i = 0; i < int(m_products.size()); ++i) {
+        if (i == excludeSlot || !m_products[i].isValid()) continue;
+        if (m_products[i].*(index.field()) == key && (best < 0 || preferOver(i, best))) {
+            best = i;
+        }
+    }
+    if (best >= 0) {
+        index.insert(key, best, m_products);
+    }
+}
@@ -0,0 +1,118 @@
+﻿#ifndef PRODUCTCATALOG_H
+#define PRODUCTCATALOG_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+#include <QHash>
+#include <vector>
+
+///
+/// \brief 单个产品的扁平记录（对应ProductQuery完整记录的字段）
+///
+struct ProductInfo
+{
+    qint64 productId = 0;
+    QString productName;
+    QString jobOrderNo;
+    QString materialGrade;
+    QString customerPo;
+    QString partNo;
+    QString productSerialNo;
+    QString drawingNo;
+    QString partDescription;
+    QString smeltingFurnaceNo;
+    QString heatTreatmentFurnaceNo;
+    QString heatTreatmentState;
+    QString clientName;
+    int quantity = 0;
+    QString reviewerResult;
+    QString toolName;
+    QString toolNo;
+    QString editorName;
+    QString editorOpinion;
+    QString reviewerName;
+    QString reviewerOpinion;
+    QString detectionStandardCode;
+    QString acceptanceStandardCode;
+    QString createTime;  // yyyy-MM-dd HH:mm:ss
+
+    bool isValid() const { return productId > 0; }
+    // 与查询结果/本地缓存的字段名互转
+    static ProductInfo fromRecord(const QVariantMap& record);
+    QVariantMap toRecord() const;
+};
+
+///
+/// \brief 内存产品目录：产品按槽位连续存放，工作令号、产品序列号各建一个开放寻址哈希索引，
+/// 工作令号另维护按创建时间排列的数组用于下拉框前缀搜索；按product_id覆盖写入（upsert）
+/// 同一工作令号/序列号对应多个产品时，索引指向创建时间最新的一个；非线程安全，仅在界面线程使用
+///
+class ProductCatalog
+{
+public:
+    ProductCatalog();
+
+    int size() const { return m_byId.size(); }
+    bool isEmpty() const { return m_byId.isEmpty(); }
+    void clear();
+    void reserve(int count);
+
+    // 按product_id插入或覆盖
+    void upsert(const ProductInfo& info);
+    void upsert(const QVariantMap& record) { upsert(ProductInfo::fromRecord(record)); }
+    void remove(qint64 productId);
+
+    // 查找，未找到返回nullptr（指针在下次修改目录前有效）
+    const ProductInfo* findById(qint64 productId) const;
+    const ProductInfo* findByJobOrder(const QString& jobOrderNo) const;
+    const ProductInfo* findBySerialNo(const QString& serialNo) const;
+
+    // 以prefix开头的工作令号（按创建时间先后、去重，与在线分页查询的顺序一致），最多limit个
+    QStringList jobOrdersWithPrefix(const QString& prefix, int limit) const;
+
+private:
+    // 开放寻址（线性探测）字符串索引：桶内只存哈希与槽位，键从产品记录的field字段读取
+    class StringIndex
+    {
+    public:
+        explicit StringIndex(QString ProductInfo::*field) : m_field(field) {}
+        int find(const QString& key, const std::vector<ProductInfo>& products) const;
+        // 插入或替换key对应的槽位
+        void insert(const QString& key, int slot, const std::vector<ProductInfo>& products);
+        void remove(const QString& key, const std::vector<ProductInfo>& products);
+        void clear();
+        void reserve(int count);
+        QString ProductInfo::*field() const { return m_field; }
+
+    private:
+        enum { EMPTY = -1, DELETED = -2 };
+        struct Bucket { uint hash = 0; int slot = EMPTY; };
+        // 返回key所在桶，未找到返回-1
+        int findBucket(const QString& key, uint hash, const std::vector<ProductInfo>& products) const;
+        void rehash(int capacity);
+
+        QString ProductInfo::*m_field;
+        std::vector<Bucket> m_buckets;  // 容量为2的幂
+        int m_count = 0;
+        int m_deleted = 0;
+    };
+
+    // 槽位product是否应取代existing成为索引指向（创建时间更新者优先）
+    bool preferOver(int slot, int existing) const;
+    // 把槽位加入/移出各字符串索引
+    void indexSlot(int slot);
+    void unindexSlot(int slot, const ProductInfo* next);
+    // key的索引指向被移除后，从其余产品中重新选出指向
+    void reindexKey(StringIndex& index, const QString& key, int excludeSlot);
+
+    std::vector<ProductInfo> m_products;    // 产品槽位（已删除槽位productId为0）
+    std::vector<int> m_freeSlots;           // 可复用的空槽位
+    QHash<qint64, int> m_byId;              // product_id→槽位
+    StringIndex m_byJobOrder;
+    StringIndex m_bySerialNo;
+    mutable QStringList m_orderedJobOrders; // 按创建时间排列的工作令号（前缀搜索用，修改后惰性重建）
+    mutable bool m_orderDirty = false;
+};
+
+#endif // PRODUCTCATALOG_H
@@ -0,0 +1,157 @@
+﻿#include "productquery.h"
+
+static const QString PRODUCT_TABLE = "product_base_info";
+
+ProductQuery::JobOrderPage ProductQuery::fetchJobOrderPage(const QString &prefix, const PageCursor &after, int pageSize)
+{
+    JobOrderPage page;
+    pageSize = qMax(1, pageSize);
+
+    QStringList conditions;
+    QList<QVariant> params;
+    conditions << "p.job_order_no IS NOT NULL" << "p.job_order_no <> ''";
+    if (!prefix.trimmed().isEmpty()) {
+        conditions << "p.job_order_no LIKE ?" + SqlService::Get().likeEscapeClause();
+        params << escapeLike(prefix.trimmed()) + "%";
+    }
+    if (!after.isStart()) {
+        conditions << "(p.create_time > ? OR (p.create_time = ? AND p.product_id > ?))";
+        params << after.createTime << after.createTime << after.productId;
+    }
+    // 多取一行用于判断是否还有下一页
+    QString sql = QString("SELECT p.product_id, p.job_order_no, p.create_time FROM %1 p WHERE %2 "
+                          "ORDER BY p.create_time ASC, p.product_id ASC LIMIT %3")
+            .arg(PRODUCT_TABLE).arg(conditions.join(" AND ")).arg(pageSize + 1);
+
+    SqlService::QueryResult result = SqlService::Get().GetDataCached(sql, params);
+    if (!result.success) {
+        page.errorMsg = result.errorMsg;
+        return page;
+    }
+    page.success = true;
+    page.hasMore = result.data.size() > pageSize;
+    const int count = qMin(pageSize, result.data.size());
+    for (int i = 0; i < count; ++i) {
+        const QVariantMap& row = result.data.at(i);
+        page.jobOrders.append(row.value("job_order_no").toString().trimmed());
+        page.next.createTime = row.value("create_time");
+        page.next.productId = row.value("product_id").toLongLong();
+    }
+    if (count == 0) {
+        page.next = after;
+    }
+    return page;
+}
+
+SqlService::QueryResult ProductQuery::fetchChangedRecords(SqlService::DeltaCursor &cursor, int limit,
+                                                          const SqlCancelTokenPtr &cancel)
+{
+    const QString changeExpr = changeTimeExpr();
+    const QString keyExpr = "p.product_id";
+    QString sql = recordSelectSql(QString("%1 AS delta_time, %2 AS delta_key").arg(changeExpr, keyExpr));
+    // 同步必须读到最新数据，不走结果缓存
+    SqlService::QueryOptions options;
+    options.cancel = cancel;
+    return SqlService::Get().GetDelta(sql, changeExpr, keyExpr, cursor, limit, options);
+}
+
+void ProductQuery::invalidateCache()
+{
+    SqlService::Get().queryCache().invalidateTables(QSet<QString>() << PRODUCT_TABLE);
+}
+
+QVariantMap ProductQuery::fetchRecordByJobOrder(const QString &jobOrder, QString *errorMsg)
+{
+    QString sql = recordSelectSql() + " WHERE p.job_order_no = ? ORDER BY p.create_time DESC, p.product_id DESC LIMIT 1";
+    SqlService::QueryResult result = SqlService::Get().GetDataCached(sql, QList<QVariant>() << jobOrder.trimmed());
+    if (errorMsg) *errorMsg = result.errorMsg;
+    if (!result.success || result.data.isEmpty()) {
+        return QVariantMap();
+    }
+    return result.data.first();
+}
+
+const QMap<QString, QString> &ProductQuery::fieldHeaders()
+{
+    static const QMap<QString, QString> fieldToHeaderMap = {
+           {"product_id", "产品ID"},
+           {"product_name", "产品名称"},
+           {"job_order_no", "工作令号"},
+           {"material_grade", "材质"},
+           {"customer_po", "客户单号"},
+           {"part_no", "零件号"},
+           {"product_serial_no", "产品序列号"},
+           {"drawing_no", "图号"},
+           {"part_description", "零件描述"},
+           {"smelting_furnace_no", "冶炼炉号"},
+           {"heat_treatment_furnace_no", "热处理炉号"},
+           {"heat_treatment_state", "热处理状态"},
+           {"client_name", "委托单位"},
+           {"quantity", "产品数量"},
+           {"reviewer_result", "审核结果"},
+           {"tool_name", "测量工具名称"},
+           {"editor_name", "编制人员"},
+           {"editor_opinion", "编制人员意见"},
+           {"reviewer_name", "审核人员"},
+           {"reviewer_opinion", "审核人员意见"},
+           {"detection_standard_code", "检测标准号"},
+           {"acceptance_standard_code", "验收标准号"},
+           {"create_time", "年月日"}
+    };
+    return fieldToHeaderMap;
+}
+
+QString ProductQuery::recordSelectSql(const QString &extraColumns)
+{
+    return QString(R"(
+               SELECT
+                   p.product_id,
+                   p.product_name,
+                   p.job_order_no,
+                   p.material_grade,
+                   p.customer_po,
+                   p.part_no,
+                   p.product_serial_no,
+                   p.drawing_no,
+                   p.part_description,
+                   p.smelting_furnace_no,
+                   p.heat_treatment_furnace_no,
+                   p.heat_treatment_state,
+                   p.client_name,
+                   p.quantity,
+                   p.reviewer_result,
+                   m.tool_name, -- 关联测量工具表
+                   m.tool_no,
+                   p.editor_name,
+                   p.editor_opinion,
+                   p.reviewer_name,
+                   p.reviewer_opinion,
+                   d.standard_code AS detection_standard_code, -- 关联检测标准表
+                   a.acceptance_code AS acceptance_standard_code, -- 关联验收标准表
+                   %3 AS create_time%2
+               FROM %1 p
+               LEFT JOIN measurement_tool m ON p.tool_id = m.tool_id
+               LEFT JOIN detection_standard d ON p.standard_id = d.standard_id
+               LEFT JOIN acceptance_standard a ON p.acceptance_id = a.acceptance_id
+           )").arg(PRODUCT_TABLE,
+                   extraColumns.isEmpty() ? QString() : ",\n                   " + extraColumns,
+                   SqlService::Get().dateTimeExpr("p.create_time"));
+}
+
+QString ProductQuery::changeTimeExpr()
+{
+    SqlService::TableSchema schema = SqlService::Get().getTableSchema(PRODUCT_TABLE);
+    if (schema.columns.contains("update_time")) {
+        return "COALESCE(p.update_time, p.create_time)";
+    }
+    return "p.create_time";
+}
+
+QString ProductQuery::escapeLike(const QString &text)
+{
+    QString escaped = text;
+    escaped.replace("\\", "\\\\");
+    escaped.replace("%", "\\%");
+    escaped.replace("_", "\\_");
+    return escaped;
+}
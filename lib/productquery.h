@@ -0,0 +1,59 @@
+﻿#ifndef PRODUCTQUERY_H
+#define PRODUCTQUERY_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QMap>
+#include "sqlservice.h"
+
+///
+/// \brief 产品数据查询（product_base_info 及其关联表）
+/// 列表按(create_time, product_id)键集分页，只取工作令号；完整记录按工作令号单独查询
+/// 建议索引：product_base_info(create_time, product_id)、product_base_info(job_order_no)
+/// 增量同步按COALESCE(update_time, create_time)取变更，数据量大时（MySQL 8.0.13+）建函数索引：
+///   ALTER TABLE product_base_info ADD INDEX idx_change_time ((COALESCE(update_time, create_time)), product_id)
+///
+class ProductQuery
+{
+public:
+    // 键集分页游标：上一页最后一行的(create_time, product_id)
+    struct PageCursor {
+        QVariant createTime;
+        qint64 productId = 0;
+        bool isStart() const { return !createTime.isValid(); }
+    };
+
+    // 一页工作令号
+    struct JobOrderPage {
+        bool success = false;
+        QString errorMsg;
+        QStringList jobOrders;  // 本页工作令号（按创建时间升序）
+        PageCursor next;        // 下一页游标
+        bool hasMore = false;   // 是否还有下一页
+    };
+
+    // 按工作令号前缀分页查询（prefix为空查全部）
+    static JobOrderPage fetchJobOrderPage(const QString& prefix, const PageCursor& after, int pageSize = 200);
+    // 查询变更时间（update_time，无该列时为create_time）晚于游标的完整产品记录，最多limit行，cursor推进到最后一行；
+    // 用于增量同步，调用方按product_id覆盖已有记录；cancel可在其它线程取消正在执行的查询
+    static SqlService::QueryResult fetchChangedRecords(SqlService::DeltaCursor& cursor, int limit = 1000,
+                                                       const SqlCancelTokenPtr& cancel = SqlCancelTokenPtr());
+    // 按工作令号查询完整产品记录（含测量工具、检测标准、验收标准），未找到时返回空
+    static QVariantMap fetchRecordByJobOrder(const QString& jobOrder, QString* errorMsg = nullptr);
+    // 淘汰结果缓存中读取过产品表的条目（增量同步发现服务器数据变化后调用）
+    static void invalidateCache();
+
+    // 字段名→中文表头
+    static const QMap<QString, QString>& fieldHeaders();
+
+private:
+    // 完整记录查询的SELECT/FROM部分（不含WHERE/ORDER BY），extraColumns追加在字段列表末尾
+    static QString recordSelectSql(const QString& extraColumns = QString());
+    // 变更时间表达式（product_base_info无update_time列时只用create_time）
+    static QString changeTimeExpr();
+    // 转义LIKE通配符
+    static QString escapeLike(const QString& text);
+};
+
+#endif // PRODUCTQUERY_H
@@ -0,0 +1,191 @@
+﻿#include "querycache.h"
+#include <QRegularExpression>
+
+QueryCache::QueryCache()
+{
+    m_clock.start();
+}
+
+bool QueryCache::lookup(const QString &key, QList<QVariantMap> *data)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) return false;
+    if (it->expireAt <= m_clock.elapsed()) {
+        removeEntry(key);
+        return false;
+    }
+    // 移到LRU链表头部
+    m_lru.splice(m_lru.begin(), m_lru, it->lruPos);
+    if (data) *data = it->data; // QList隐式共享，拷贝为O(1)
+    return true;
+}
+
+void QueryCache::insert(const QString &key, const QList<QVariantMap> &data, const QSet<QString> &tables,
+                        quint64 startGeneration, int ttlMs)
+{
+    qint64 bytes = estimateBytes(data) + key.size() * 2;
+    QMutexLocker locker(&m_mutex);
+    if (startGeneration != m_generation) return;
+    if (m_entries.contains(key)) {
+        removeEntry(key);
+    }
+    // 单个结果超过上限的不缓存
+    if (bytes > m_maxBytes) return;
+
+    m_lru.push_front(key);
+    Entry entry;
+    entry.data = data;
+    entry.tables = tables;
+    entry.expireAt = m_clock.elapsed() + (ttlMs > 0 ? ttlMs : m_defaultTtlMs);
+    entry.bytes = bytes;
+    entry.lruPos = m_lru.begin();
+    m_entries.insert(key, entry);
+    for (const QString& table : tables) {
+        m_tableIndex[table].insert(key);
+    }
+    m_usedBytes += bytes;
+    evictOverflow();
+}
+
+void QueryCache::invalidateTables(const QSet<QString> &tables)
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_generation;
+    for (const QString& table : tables) {
+        QSet<QString> keys = m_tableIndex.take(table.toLower());
+        for (const QString& key : keys) {
+            removeEntry(key);
+        }
+    }
+}
+
+void QueryCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_generation;
+    m_entries.clear();
+    m_tableIndex.clear();
+    m_lru.clear();
+    m_usedBytes = 0;
+}
+
+void QueryCache::removeEntry(const QString &key)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) return;
+    for (const QString& table : it->tables) {
+        auto tableIt = m_tableIndex.find(table);
+        if (tableIt != m_tableIndex.end()) {
+            tableIt->remove(key);
+            if (tableIt->isEmpty()) m_tableIndex.erase(tableIt);
+        }
+    }
+    m_lru.erase(it->lruPos);
+    m_usedBytes -= it->bytes;
+    m_entries.erase(it);
+}
+
+void QueryCache::evictOverflow()
+{
+    while (m_usedBytes > m_maxBytes && !m_lru.empty()) {
+        removeEntry(m_lru.back());
+    }
+}
+
+QString QueryCache::makeKey(const QString &sql, const QList<QVariant> &params)
+{
+    QString key = normalizeSql(sql);
+    for (const QVariant& param : params) {
+        key += QChar(0x1e);
+        key += QString::number(param.userType());
+        key += QChar(':');
+        key += param.isNull() ? QString("NULL") : param.toString();
+    }
+    return key;
+}
+
+QString QueryCache::normalizeSql(const QString &sql)
+{
+    QString normalized;
+    normalized.reserve(sql.size());
+    QChar quote;
+    bool pendingSpace = false;
+    for (const QChar ch : sql) {
+        if (!quote.isNull()) {
+            normalized += ch;
+            if (ch == quote) quote = QChar();
+            continue;
+        }
+        if (ch.isSpace()) {
+            pendingSpace = !normalized.isEmpty();
+            continue;
+        }
+        if (pendingSpace) {
+            normalized += QChar(' ');
+            pendingSpace = false;
+        }
+        if (ch == QChar('\'') || ch == QChar('"') || ch == QChar('`')) {
+            quote = ch;
+        }
+        normalized += ch;
+    }
+    return normalized;
+}
+
+// 取表名：去掉反引号与库名前缀并转小写
+static QString plainTableName(const QString& name)
+{
+    QString table = name;
+    table.remove(QChar('`'));
+    int dot = table.lastIndexOf(QChar('.'));
+    if (dot >= 0) table = table.mid(dot + 1);
+    return table.toLower();
+}
+
+QSet<QString> QueryCache::tablesRead(const QString &sql)
+{
+    static const QRegularExpression regex("\\b(?:FROM|JOIN)\\s+(`?[\\w$]+`?(?:\\.`?[\\w$]+`?)?)",
+                                          QRegularExpression::CaseInsensitiveOption);
+    QSet<QString> tables;
+    QRegularExpressionMatchIterator it = regex.globalMatch(sql);
+    while (it.hasNext()) {
+        tables.insert(plainTableName(it.next().captured(1)));
+    }
+    return tables;
+}
+
+QSet<QString> QueryCache::tablesWritten(const QString &sql)
+{
+    static const QRegularExpression regex(
+                "^\\s*(?:INSERT(?:\\s+IGNORE)?\\s+INTO|REPLACE\\s+INTO|UPDATE(?:\\s+IGNORE)?|DELETE\\s+FROM|"
+                "TRUNCATE(?:\\s+TABLE)?|ALTER\\s+TABLE|DROP\\s+TABLE(?:\\s+IF\\s+EXISTS)?|"
+                "CREATE\\s+TABLE(?:\\s+IF\\s+NOT\\s+EXISTS)?)\\s+(`?[\\w$]+`?(?:\\.`?[\\w$]+`?)?)",
+                QRegularExpression::CaseInsensitiveOption);
+    QSet<QString> tables;
+    QRegularExpressionMatch match = regex.match(sql);
+    if (match.hasMatch()) {
+        tables.insert(plainTableName(match.captured(1)));
+        // 多表UPDATE/DELETE：JOIN的表也可能被修改
+        tables.unite(tablesRead(sql));
+    }
+    return tables;
+}
+
+qint64 QueryCache::estimateBytes(const QList<QVariantMap> &data)
+{
+    qint64 bytes = 0;
+    for (const QVariantMap& row : data) {
+        bytes += 64; // 行对象开销
+        for (auto it = row.constBegin(); it != row.constEnd(); ++it) {
+            bytes += 48; // 节点+QVariant开销（字段名与结果集共享）
+            const QVariant& value = it.value();
+            if (value.type() == QVariant::String) {
+                bytes += value.toString().size() * 2;
+            } else if (value.type() == QVariant::ByteArray) {
+                bytes += value.toByteArray().size();
+            }
+        }
+    }
+    return bytes;
+}
@@ -0,0 +1,77 @@
+﻿#ifndef QUERYCACHE_H
+#define QUERYCACHE_H
+
+#include <QString>
+#include <QList>
+#include <QVariant>
+#include <QVariantMap>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <list>
+
+///
+/// \brief 查询结果缓存
+/// 键为规范化SQL+绑定参数，条目带TTL，按估算内存上限做LRU淘汰；
+/// 记录每个条目读取的表，写入某表时淘汰所有读取过该表的条目
+///
+class QueryCache
+{
+public:
+    QueryCache();
+
+    // 命中且未过期时返回true并输出结果
+    bool lookup(const QString& key, QList<QVariantMap>* data);
+    // 当前失效代数：每次淘汰写入的表时递增
+    quint64 generation() const { QMutexLocker locker(&m_mutex); return m_generation; }
+    // 写入缓存（tables为该查询读取的表，ttlMs<=0使用默认TTL）；
+    // 查询期间发生过失效（代数不等于startGeneration）时不写入，避免缓存写入前读到的旧数据
+    void insert(const QString& key, const QList<QVariantMap>& data, const QSet<QString>& tables,
+                quint64 startGeneration, int ttlMs = 0);
+    // 淘汰读取过指定表的条目
+    void invalidateTables(const QSet<QString>& tables);
+    // 清空缓存
+    void clear();
+
+    void setDefaultTtl(int ms) { QMutexLocker locker(&m_mutex); m_defaultTtlMs = qMax(1, ms); }
+    void setMaxBytes(qint64 bytes) { QMutexLocker locker(&m_mutex); m_maxBytes = qMax<qint64>(0, bytes); evictOverflow(); }
+    qint64 usedBytes() const { QMutexLocker locker(&m_mutex); return m_usedBytes; }
+    int count() const { QMutexLocker locker(&m_mutex); return m_entries.size(); }
+
+public:
+    // 缓存键：规范化SQL + 参数（类型+值）
+    static QString makeKey(const QString& sql, const QList<QVariant>& params);
+    // 规范化SQL：合并引号外的连续空白、去掉首尾空白
+    static QString normalizeSql(const QString& sql);
+    // 解析SELECT读取的表（FROM/JOIN），表名统一小写且去掉库名前缀
+    static QSet<QString> tablesRead(const QString& sql);
+    // 解析写语句修改的表（INSERT/REPLACE/UPDATE/DELETE/TRUNCATE/ALTER/DROP/CREATE），无法识别时返回空
+    static QSet<QString> tablesWritten(const QString& sql);
+    // 估算结果集内存占用
+    static qint64 estimateBytes(const QList<QVariantMap>& data);
+
+private:
+    struct Entry {
+        QList<QVariantMap> data;
+        QSet<QString> tables;
+        qint64 expireAt = 0;                  // 过期时刻（m_clock毫秒）
+        qint64 bytes = 0;
+        std::list<QString>::iterator lruPos;  // 在LRU链表中的位置
+    };
+    void removeEntry(const QString& key);     // 调用方需持有m_mutex
+    void evictOverflow();                     // 调用方需持有m_mutex
+
+private:
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    QHash<QString, QSet<QString>> m_tableIndex; // 表名→读取过该表的缓存键
+    std::list<QString> m_lru;                   // 最近使用在前
+    QElapsedTimer m_clock;
+    quint64 m_generation = 0;
+    qint64 m_usedBytes = 0;
+    qint64 m_maxBytes = 32 * 1024 * 1024;       // 默认32MB
+    int m_defaultTtlMs = 30000;                 // 默认30秒
+};
+
+#endif // QUERYCACHE_H
@@ -0,0 +1,383 @@
+﻿#include "reportqueue.h"
+#include "ilogger.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QHash>
+#include <QUuid>
+#include <QSaveFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <objbase.h>
+
+static const QString EVENT_QUEUED = "queued";
+static const QString EVENT_STARTED = "started";
+static const QString EVENT_DONE = "done";
+static const QString EVENT_FAILED = "failed";
+static const QString EVENT_CANCELLED = "cancelled";
+// 程序正常退出时中止：下次重新生成，不计入连续未完成次数
+static const QString EVENT_INTERRUPTED = "interrupted";
+
+ReportQueue::ReportQueue(QObject *parent) : QObject(parent)
+{
+    m_worker = QThread::create([this]() { workerLoop(); });
+    m_worker->start();
+}
+
+ReportQueue::~ReportQueue()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_jobs.clear();
+        if (m_runningCancel) m_runningCancel->store(true);
+        m_condition.wakeAll();
+    }
+    m_worker->wait();
+    delete m_worker;
+    m_worker = nullptr;
+}
+
+int ReportQueue::openJournal(const QString &journalPath)
+{
+    // 回放日志：每个任务取入队记录、最后一条记录和开始次数，按首次出现的顺序排列
+    struct Replay {
+        QJsonObject queued;
+        QJsonObject last;
+        int attempts = 0;
+    };
+    QStringList keys;
+    QHash<QString, Replay> replays;
+    QFile file(journalPath);
+    if (file.open(QIODevice::ReadOnly)) {
+        while (!file.atEnd()) {
+            const QByteArray line = file.readLine().trimmed();
+            if (line.isEmpty()) continue;
+            // 异常退出时最后一行可能只写了一半，无法解析的行跳过
+            const QJsonObject record = QJsonDocument::fromJson(line).object();
+            const QString key = record.value("key").toString();
+            const QString event = record.value("event").toString();
+            if (key.isEmpty() || event.isEmpty()) continue;
+            if (!replays.contains(key)) keys << key;
+            Replay &replay = replays[key];
+            if (event == EVENT_QUEUED) {
+                replay.queued = record;
+                replay.attempts = record.value("attempts").toInt();
+            } else if (event == EVENT_STARTED) {
+                ++replay.attempts;
+            } else if (event == EVENT_INTERRUPTED) {
+                replay.attempts = qMax(0, replay.attempts - 1);
+            }
+            replay.last = record;
+        }
+        file.close();
+    }
+
+    // 整理：未完成的任务合并为一条入队记录（带已开始次数），已结束的任务只保留最后一条记录
+    const QDateTime now = QDateTime::currentDateTime();
+    QList<Job> resumeJobs;
+    QByteArray compacted;
+    for (const QString &key : keys) {
+        const Replay &replay = replays.value(key);
+        QJsonObject record = replay.last;
+        const QString event = record.value("event").toString();
+        const bool unfinished = !replay.queued.isEmpty()
+                && (event == EVENT_QUEUED || event == EVENT_STARTED || event == EVENT_INTERRUPTED);
+        if (unfinished && replay.attempts >= MAX_ATTEMPTS) {
+            record = QJsonObject();
+            record["event"] = EVENT_FAILED;
+            record["key"] = key;
+            record["time"] = now.toString(Qt::ISODate);
+            record["save"] = replay.queued.value("save");
+            record["error"] = QString("连续%1次未完成，不再自动恢复").arg(replay.attempts);
+            LOG_WARN(QString("报告任务不再自动恢复（连续%1次未完成）：%2")
+                     .arg(replay.attempts).arg(replay.queued.value("save").toString()));
+        } else if (unfinished) {
+            record = replay.queued;
+            record["attempts"] = replay.attempts;
+            Job job = jobFromJson(replay.queued);
+            job.key = key;
+            resumeJobs << job;
+        } else {
+            const QDateTime time = QDateTime::fromString(record.value("time").toString(), Qt::ISODate);
+            if (!time.isValid() || time.daysTo(now) > JOURNAL_RETAIN_DAYS) continue;
+        }
+        compacted += QJsonDocument(record).toJson(QJsonDocument::Compact);
+        compacted += '\n';
+    }
+
+    QDir().mkpath(QFileInfo(journalPath).absolutePath());
+    QSaveFile saveFile(journalPath);
+    if (!saveFile.open(QIODevice::WriteOnly) || saveFile.write(compacted) != compacted.size() || !saveFile.commit()) {
+        LOG_WARN(QString("整理报告任务日志失败：%1").arg(saveFile.errorString()));
+    }
+    {
+        QMutexLocker locker(&m_journalMutex);
+        m_journal.close();
+        m_journal.setFileName(journalPath);
+        if (!m_journal.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            LOG_WARN(QString("无法打开报告任务日志：%1").arg(m_journal.errorString()));
+        }
+    }
+
+    for (const Job &job : resumeJobs) {
+        enqueueJob(job, false);
+    }
+    return resumeJobs.size();
+}
+
+int ReportQueue::enqueue(const Job &job)
+{
+    return enqueueJob(job, true);
+}
+
+int ReportQueue::enqueueJob(const Job &job, bool journal)
+{
+    Job queued = job;
+    if (queued.key.isEmpty()) {
+        queued.key = QUuid::createUuid().toString();
+    }
+    int jobId = 0;
+    int pending = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        // 新任务：保存路径与已有文件或未完成的任务重名时加序号，避免后生成的报告覆盖前一份
+        // （恢复的任务沿用原路径，由Word覆盖上次未写完的文件）
+        if (journal) {
+            queued.savePath = uniqueSavePathLocked(queued.savePath);
+            // 先记录入队再交给后台线程，保证日志中入队记录在开始记录之前
+            writeJournal(EVENT_QUEUED, queued.key, jobToJson(queued));
+        }
+        jobId = m_nextJobId++;
+        m_jobs.append(qMakePair(jobId, queued));
+        pending = m_jobs.size() + (m_runningJobId != 0 ? 1 : 0);
+        m_condition.wakeOne();
+    }
+    emit jobQueued(jobId, pending);
+    return jobId;
+}
+
+bool ReportQueue::cancel(int jobId)
+{
+    Job job;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (jobId != 0 && jobId == m_runningJobId) {
+            // 由后台线程在下一个检查点停止并发出jobFinished
+            if (m_runningCancel) m_runningCancel->store(true);
+            return true;
+        }
+        int index = -1;
+        for (int i = 0; i < m_jobs.size(); ++i) {
+            if (m_jobs.at(i).first == jobId) {
+                index = i;
+                break;
+            }
+        }
+        if (index < 0) return false;
+        job = m_jobs.takeAt(index).second;
+    }
+    QJsonObject record;
+    record["save"] = job.savePath;
+    writeJournal(EVENT_CANCELLED, job.key, record);
+    emit jobFinished(jobId, false, "已取消");
+    return true;
+}
+
+int ReportQueue::runningJobId() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_runningJobId;
+}
+
+int ReportQueue::pendingCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_jobs.size() + (m_runningJobId != 0 ? 1 : 0);
+}
+
+void ReportQueue::workerLoop()
+{
+    // QAxObject要求调用线程已初始化COM
+    const HRESULT comResult = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+    while (true) {
+        int jobId = 0;
+        Job job;
+        DimReport::CancelFlag cancel;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_jobs.isEmpty() && !m_stopping) {
+                m_condition.wait(&m_mutex);
+            }
+            if (m_stopping) break;
+            QPair<int, Job> next = m_jobs.takeFirst();
+            jobId = next.first;
+            job = next.second;
+            cancel = std::make_shared<std::atomic<bool>>(false);
+            m_runningJobId = jobId;
+            m_runningCancel = cancel;
+            m_runningSavePath = job.savePath;
+        }
+        writeJournal(EVENT_STARTED, job.key);
+        emit jobStarted(jobId, job.savePath);
+        QString message;
+        const bool success = runJob(jobId, job, cancel, &message);
+        bool stopping = false;
+        {
+            // 先清除运行状态再通知，接收方查询时已不含该任务
+            QMutexLocker locker(&m_mutex);
+            m_runningJobId = 0;
+            m_runningCancel.reset();
+            m_runningSavePath.clear();
+            stopping = m_stopping;
+        }
+        QJsonObject record;
+        record["save"] = job.savePath;
+        if (success) {
+            writeJournal(EVENT_DONE, job.key, record);
+        } else if (stopping) {
+            // 程序退出时中止：记为中断，下次打开日志时重新生成
+            writeJournal(EVENT_INTERRUPTED, job.key);
+        } else if (cancel->load()) {
+            writeJournal(EVENT_CANCELLED, job.key, record);
+        } else {
+            record["error"] = message;
+            writeJournal(EVENT_FAILED, job.key, record);
+        }
+        emit jobFinished(jobId, success, message);
+    }
+    if (SUCCEEDED(comResult)) {
+        CoUninitialize();
+    }
+}
+
+bool ReportQueue::runJob(int jobId, const Job &job, const DimReport::CancelFlag &cancel, QString *message)
+{
+    DimReport report;
+    report.setTemplatePath(job.templatePath);
+    report.setSavePath(job.savePath);
+    report.setProductParam(job.product);
+    for (const DimReport::InspectionParam &param : job.params) {
+        report.setInspectParam(param);
+    }
+    report.setCancelFlag(cancel);
+
+    // 在本线程直接处理DimReport的信号：GenerateReport在非界面线程时以信号代替弹框
+    bool finished = false;
+    bool success = false;
+    connect(&report, &DimReport::reportProgress, [this, jobId](int phase, const QString &text) {
+        emit jobProgress(jobId, phase, text);
+    });
+    connect(&report, &DimReport::reportInfo, [&](const QString &, const QString &) {
+        finished = true;
+        success = true;
+        *message = job.savePath;
+    });
+    auto onFailure = [&](const QString &, const QString &content) {
+        finished = true;
+        success = false;
+        *message = content;
+    };
+    connect(&report, &DimReport::reportError, onFailure);
+    connect(&report, &DimReport::reportWarning, onFailure);
+
+    report.GenerateReport();
+    if (!finished) {
+        *message = cancel->load() ? "已取消" : "报告生成未完成";
+    }
+    return success;
+}
+
+QString ReportQueue::uniqueSavePathLocked(const QString &savePath) const
+{
+    auto inUse = [this](const QString &path) {
+        if (QFile::exists(path) || path == m_runningSavePath) return true;
+        for (const QPair<int, Job> &queued : m_jobs) {
+            if (queued.second.savePath == path) return true;
+        }
+        return false;
+    };
+    const QFileInfo info(savePath);
+    const QString base = QDir(info.path()).filePath(info.completeBaseName());
+    QString candidate = savePath;
+    for (int index = 2; inUse(candidate); ++index) {
+        candidate = QString("%1_%2.%3").arg(base).arg(index).arg(info.suffix());
+    }
+    return candidate;
+}
+
+void ReportQueue::writeJournal(const QString &event, const QString &key, QJsonObject record)
+{
+    record["event"] = event;
+    record["key"] = key;
+    record["time"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    const QByteArray line = QJsonDocument(record).toJson(QJsonDocument::Compact) + '\n';
+    QMutexLocker locker(&m_journalMutex);
+    if (!m_journal.isOpen()) return;
+    if (m_journal.write(line) != line.size() || !m_journal.flush()) {
+        LOG_WARN(QString("写入报告任务日志失败：%1").arg(m_journal.errorString()));
+    }
+}
+
+QJsonObject ReportQueue::jobToJson(const Job &job)
+{
+    QJsonObject product;
+    product["jobOrder"] = job.product.jobOrder;
+    product["materialGrade"] = job.product.materialGrade;
+    product["customer"] = job.product.customer;
+    product["productSerialNo"] = job.product.productSerialNo;
+    product["measurementTool"] = job.product.MeasurementTool;
+    product["measurementNo"] = job.product.MeasurementNo;
+    product["reviewName"] = job.product.reviewName;
+    product["inspector"] = job.product.Inspector;
+
+    // 参数值保持原类型：数字为double，N/A、无效值等为字符串
+    QJsonArray params;
+    for (const DimReport::InspectionParam &param : job.params) {
+        QJsonObject item;
+        item["name"] = param.name;
+        item["defaultValue"] = QJsonValue::fromVariant(param.defaultValue);
+        item["maxValue"] = QJsonValue::fromVariant(param.maxValue);
+        item["minValue"] = QJsonValue::fromVariant(param.minValue);
+        item["actualValue"] = QJsonValue::fromVariant(param.actualValue);
+        item["offset"] = QJsonValue::fromVariant(param.offset);
+        item["overOffset"] = QJsonValue::fromVariant(param.overOffset);
+        params.append(item);
+    }
+
+    QJsonObject object;
+    object["template"] = job.templatePath;
+    object["save"] = job.savePath;
+    object["product"] = product;
+    object["params"] = params;
+    return object;
+}
+
+ReportQueue::Job ReportQueue::jobFromJson(const QJsonObject &object)
+{
+    Job job;
+    job.templatePath = object.value("template").toString();
+    job.savePath = object.value("save").toString();
+    const QJsonObject product = object.value("product").toObject();
+    job.product.jobOrder = product.value("jobOrder").toString();
+    job.product.materialGrade = product.value("materialGrade").toString();
+    job.product.customer = product.value("customer").toString();
+    job.product.productSerialNo = product.value("productSerialNo").toString();
+    job.product.MeasurementTool = product.value("measurementTool").toString();
+    job.product.MeasurementNo = product.value("measurementNo").toString();
+    job.product.reviewName = product.value("reviewName").toString();
+    job.product.Inspector = product.value("inspector").toString();
+    for (const QJsonValue &value : object.value("params").toArray()) {
+        const QJsonObject item = value.toObject();
+        DimReport::InspectionParam param;
+        param.name = item.value("name").toString();
+        param.defaultValue = item.value("defaultValue").toVariant();
+        param.maxValue = item.value("maxValue").toVariant();
+        param.minValue = item.value("minValue").toVariant();
+        param.actualValue = item.value("actualValue").toVariant();
+        param.offset = item.value("offset").toVariant();
+        param.overOffset = item.value("overOffset").toVariant();
+        job.params.append(param);
+    }
+    return job;
+}
@@ -0,0 +1,91 @@
+﻿#ifndef REPORTQUEUE_H
+#define REPORTQUEUE_H
+
+#include <QObject>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QList>
+#include <QPair>
+#include <QThread>
+#include <QFile>
+#include <QJsonObject>
+#include "reporttool.h"
+
+///
+/// \brief 报告生成队列
+/// 报告任务排队后由一个后台线程依次生成：线程内初始化COM（单线程套间），Word自动化只在该线程进行，
+/// 界面线程不再等待Word。各阶段进度与结果通过信号通知（跨线程自动排队到接收者线程），
+/// 排队中的任务可直接移除，正在生成的任务在阶段之间或填写每行数据前停止。
+/// 打开任务日志后，入队、开始、完成、失败、取消逐行追加到日志文件（JSON Lines）；
+/// 程序异常退出后再次打开时，未完成的任务重新排队，已完成或已取消的任务跳过
+///
+class ReportQueue : public QObject
+{
+    Q_OBJECT
+public:
+    struct Job {
+        QString templatePath;
+        QString savePath;
+        DimReport::ProductParam product;
+        QList<DimReport::InspectionParam> params;
+        QString key;             // 任务日志中的标识，入队时为空则自动生成
+    };
+
+    // 同一任务连续中断（开始后未记录结果，程序正常退出时的中止不计）达到此次数不再自动恢复，避免Word卡死的任务反复拖垮程序
+    static const int MAX_ATTEMPTS = 3;
+    // 任务日志中已结束任务的保留天数
+    static const int JOURNAL_RETAIN_DAYS = 30;
+
+    explicit ReportQueue(QObject *parent = nullptr);
+    // 取消全部任务并等待后台线程结束
+    ~ReportQueue() override;
+
+    // 打开任务日志并恢复上次未完成的任务（按原入队顺序重新排队），返回恢复的任务数；
+    // 打开时整理日志：只保留未完成任务和近期已结束任务的记录
+    int openJournal(const QString &journalPath);
+
+    // 加入队列，返回任务编号
+    int enqueue(const Job &job);
+    // 取消排队中或正在生成的任务；任务不存在时返回false
+    bool cancel(int jobId);
+    // 正在生成的任务编号（无则为0）
+    int runningJobId() const;
+    // 未完成的任务数（含正在生成的）
+    int pendingCount() const;
+
+signals:
+    void jobQueued(int jobId, int pendingCount);
+    void jobStarted(int jobId, const QString &savePath);
+    // phase为DimReport::Phase
+    void jobProgress(int jobId, int phase, const QString &text);
+    // 成功时message为保存路径，失败或取消时为原因
+    void jobFinished(int jobId, bool success, const QString &message);
+
+private:
+    int enqueueJob(const Job &job, bool journal);
+    // 与已有文件、排队中或正在生成的任务不重名的保存路径（调用方需持有m_mutex）
+    QString uniqueSavePathLocked(const QString &savePath) const;
+    void workerLoop();
+    // 生成一份报告，返回是否成功；message为保存路径或失败原因
+    bool runJob(int jobId, const Job &job, const DimReport::CancelFlag &cancel, QString *message);
+
+    // 追加一条任务状态记录，写入后立即刷新
+    void writeJournal(const QString &event, const QString &key, QJsonObject record = QJsonObject());
+    static QJsonObject jobToJson(const Job &job);
+    static Job jobFromJson(const QJsonObject &object);
+
+private:
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+    QList<QPair<int, Job>> m_jobs;   // 排队中的任务
+    int m_nextJobId = 1;
+    int m_runningJobId = 0;
+    DimReport::CancelFlag m_runningCancel;
+    QString m_runningSavePath;
+    bool m_stopping = false;
+    QThread *m_worker = nullptr;
+    QMutex m_journalMutex;
+    QFile m_journal;                 // 未打开时不记录
+};
+
+#endif // REPORTQUEUE_H
@@ -450,6 +450,8 @@ void DimReport::GenerateReport()
 
     // 5. 初始化Word（传入临时模板路径，用上面修正后的打开方式）
     QAxObject *doc = nullptr;
+    if (abortIfCancelled(doc)) return;
+    emit reportProgress(PhaseLoadTemplate, "加载模板");
     qDebug() << "初始化Word应用程序...";
     if (!WordReportHelper::initWordAppSimple(wordApp, doc, tempTemplatePath, this)) {
         QString title = "错误";
@@ -481,8 +483,10 @@ void DimReport::GenerateReport()
     try
     {
         fillReportContent(doc);
+        if (abortIfCancelled(doc)) return;
         qDebug() << "报告内容填充完成，准备保存...";
 
+        emit reportProgress(PhaseSave, "保存报告");
         WordReportHelper::saveAndClose(doc, wordApp, cleanSavePath);
         wordApp = nullptr;
         doc = nullptr;
@@ -599,6 +603,10 @@ void DimReport::fillTableData(QAxObject *doc)
         // 8. 遍历参数，调用通用方法填充单元格（简化核心逻辑）
         for (int i = 0; i < m_paramList.count(); ++i)
         {
+            if (isCancelled()) {
+                qDebug() << "已取消，停止填充数据";
+                goto CLEANUP;
+            }
             int currentRow = targetRowIndex + i; // 计算当前行号
             const DimReport::InspectionParam &param = m_paramList.at(i);
             // 直接调用WordReportHelper静态方法，无需重复写填充逻辑
@@ -628,10 +636,29 @@ CLEANUP:
 void DimReport::fillReportContent(QAxObject *doc)
 {
     if (!doc || doc->isNull()) return;
+    emit reportProgress(PhaseFillHeader, "填写表头");
     fillProductInfo(doc);
+    if (isCancelled()) return;
+    emit reportProgress(PhaseFillTable, QString("填写检测数据（%1行）").arg(m_paramList.count()));
     fillTableData(doc);
 }
 
+bool DimReport::abortIfCancelled(QAxObject *&doc)
+{
+    if (!isCancelled()) return false;
+    WordReportHelper::cleanupWordObjects(doc, wordApp);
+    wordApp = nullptr;
+    doc = nullptr;
+    QString title = "已取消";
+    QString content = "报告生成已取消";
+    if (QThread::currentThread() == qApp->thread()) {
+        QMessageBox::information(nullptr, title, content);
+    } else {
+        emit reportWarning(title, content);
+    }
+    return true;
+}
+
 void DimReport::fillProductInfo(QAxObject *doc)
 {
     if (!doc || doc->isNull()) return;
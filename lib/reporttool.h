@@ -8,6 +8,8 @@
 #include <QObject>
 #include <Windows.h>
 #include<QThread>
+#include <atomic>
+#include <memory>
 
 // 抽象报告生成工具类
 class ReportTool
@@ -51,8 +53,20 @@ class DimReport : public QObject, public ReportTool
         void reportInfo(const QString &title, const QString &content);
         void reportError(const QString &title, const QString &content);
         void reportWarning(const QString &title, const QString &content);
+        // 进入生成阶段（phase为Phase）
+        void reportProgress(int phase, const QString &text);
 
 public:
+    // 生成阶段
+    enum Phase {
+        PhaseLoadTemplate = 0, // 复制模板、启动Word
+        PhaseFillHeader,       // 填写表头书签
+        PhaseFillTable,        // 插入并填写检测数据行
+        PhaseSave,             // 保存并关闭Word
+        PhaseCount
+    };
+    typedef std::shared_ptr<std::atomic<bool>> CancelFlag;
+
     // 公共结构体定义
     struct ProductParam {
         QString jobOrder;        // 工作令号
@@ -88,12 +102,17 @@ public:
     void setTemplatePath(const QString &path) { m_templatePath = path; }
     void setSavePath(const QString &path) { m_savePath = path; }
     void clearInspectionParams() { m_paramList.clear(); }
+    // 取消标志：各阶段之间及填写每行数据前检查，置位后关闭Word、不保存
+    void setCancelFlag(const CancelFlag &flag) { m_cancelFlag = flag; }
+    bool isCancelled() const { return m_cancelFlag && m_cancelFlag->load(); }
 
 private:
     // 具体的报告填充实现（可被子类重写）
     virtual void fillReportContent(QAxObject *doc);
     virtual void fillTableData(QAxObject *doc);
     virtual void fillProductInfo(QAxObject *doc);
+    // 已取消时清理Word对象并通知，返回true
+    bool abortIfCancelled(QAxObject *&doc);
 
 protected:
     QList<InspectionParam> m_paramList; // 存储所有检测参数
@@ -104,6 +123,7 @@ protected:
 private:
     QAxObject *wordApp = nullptr; // Word实例
     DWORD m_wordPid = 0;
+    CancelFlag m_cancelFlag;
 };
 
 #endif // REPORTTOOL_H
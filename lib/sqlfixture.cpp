@@ -0,0 +1,176 @@
+﻿#include "sqlfixture.h"
+#include "sqlservice.h"
+#include "ilogger.h"
+#include <QRandomGenerator>
+#include <QElapsedTimer>
+
+// 每50行中最后一行与上一行共用工作令号（模拟一个工作令号下多个产品）
+static const int JOB_ORDER_GROUP = 50;
+// 相邻产品创建时间间隔（秒）
+static const int CREATE_INTERVAL_SECS = 30;
+static const QString DATETIME_FORMAT = "yyyy-MM-dd HH:mm:ss";
+
+static const QStringList MATERIALS = {"42CrMo", "35CrMo", "40Cr", "45#", "Q345B", "20CrMnTi", "304", "316L"};
+static const QStringList HEAT_STATES = {"调质", "正火", "退火", "淬火+回火", "固溶"};
+static const QStringList CLIENTS = {"一分厂", "二分厂", "装备公司", "外协单位A", "外协单位B"};
+static const QStringList PEOPLE = {"张伟", "王芳", "李强", "刘洋", "陈静", "赵磊"};
+static const QStringList PRODUCT_NAMES = {"法兰", "阀体", "主轴", "齿轮", "连杆", "壳体"};
+
+QString SqlFixture::jobOrderNo(int index, const QDateTime &startTime)
+{
+    int ordinal = index / JOB_ORDER_GROUP * (JOB_ORDER_GROUP - 1) + qMin(index % JOB_ORDER_GROUP, JOB_ORDER_GROUP - 2);
+    return QString("JO%1-%2").arg(startTime.date().year()).arg(ordinal + 1, 7, 10, QChar('0'));
+}
+
+SqlFixture::Result SqlFixture::generate(const Options &options)
+{
+    Result result;
+    QElapsedTimer timer;
+    timer.start();
+    SqlService& sql = SqlService::Get();
+    if (!sql.isAvailable()) {
+        result.errorMsg = "数据库未连接";
+        return result;
+    }
+    if (sql.isMySql() && !options.allowMySql) {
+        result.errorMsg = "拒绝在MySQL上重建测试表（需设置allowMySql）";
+        return result;
+    }
+    if (!createTables(&result.errorMsg) || !insertLookupTables(options, &result.errorMsg)) {
+        return result;
+    }
+    if (!insertProducts(options, result)) {
+        return result;
+    }
+    // 表结构已重建，缓存一律失效
+    sql.invalidateSchemaCache();
+    sql.queryCache().clear();
+    result.success = true;
+    result.elapsedMs = timer.elapsed();
+    LOG_INFO(QString("测试数据生成完成：产品%1行，种子%2，耗时%3ms")
+             .arg(result.productRows).arg(options.seed).arg(result.elapsedMs));
+    return result;
+}
+
+bool SqlFixture::createTables(QString *errorMsg)
+{
+    SqlService& sql = SqlService::Get();
+    const bool mysql = sql.isMySql();
+    const QString idType = mysql ? "BIGINT NOT NULL PRIMARY KEY" : "INTEGER NOT NULL PRIMARY KEY";
+    const QString text = mysql ? "VARCHAR(64)" : "TEXT";
+    const QString longText = mysql ? "VARCHAR(255)" : "TEXT";
+    const QString dateTime = mysql ? "DATETIME" : "TEXT";
+
+    QStringList ddl;
+    ddl << "DROP TABLE IF EXISTS product_base_info"
+        << "DROP TABLE IF EXISTS measurement_tool"
+        << "DROP TABLE IF EXISTS detection_standard"
+        << "DROP TABLE IF EXISTS acceptance_standard";
+    ddl << QString("CREATE TABLE measurement_tool (tool_id %1, tool_name %2, tool_no %2)").arg(idType, text);
+    ddl << QString("CREATE TABLE detection_standard (standard_id %1, standard_code %2)").arg(idType, text);
+    ddl << QString("CREATE TABLE acceptance_standard (acceptance_id %1, acceptance_code %2)").arg(idType, text);
+    ddl << QString("CREATE TABLE product_base_info ("
+                   "product_id %1, product_name %2, job_order_no %2, material_grade %2, customer_po %2,"
+                   " part_no %2, product_serial_no %2, drawing_no %2, part_description %3,"
+                   " smelting_furnace_no %2, heat_treatment_furnace_no %2, heat_treatment_state %2,"
+                   " client_name %2, quantity INTEGER, reviewer_result %2, tool_id BIGINT,"
+                   " editor_name %2, editor_opinion %3, reviewer_name %2, reviewer_opinion %3,"
+                   " standard_id BIGINT, acceptance_id BIGINT, create_time %4 NOT NULL, update_time %4 NULL)")
+           .arg(idType, text, longText, dateTime);
+    // 与ProductQuery建议的索引一致
+    ddl << "CREATE INDEX idx_product_create ON product_base_info (create_time, product_id)"
+        << "CREATE INDEX idx_product_job_order ON product_base_info (job_order_no)";
+
+    for (const QString& statement : ddl) {
+        SqlService::QueryResult result = sql.NonQuery(statement);
+        if (!result.success) {
+            if (errorMsg) *errorMsg = result.errorMsg;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SqlFixture::insertLookupTables(const Options &options, QString *errorMsg)
+{
+    SqlService& sql = SqlService::Get();
+    QList<QVariantList> tools, detections, acceptances;
+    for (int i = 1; i <= options.toolRows; ++i) {
+        tools << QVariantList{i, QString("游标卡尺%1").arg(i), QString("TL-%1").arg(i, 4, 10, QChar('0'))};
+    }
+    for (int i = 1; i <= options.standardRows; ++i) {
+        detections << QVariantList{i, QString("GB/T %1-2008").arg(3000 + i)};
+        acceptances << QVariantList{i, QString("Q/DT %1-2020").arg(100 + i)};
+    }
+    SqlService::BatchResult result = sql.BatchInsert("measurement_tool", {"tool_id", "tool_name", "tool_no"}, tools);
+    if (result.success) {
+        result = sql.BatchInsert("detection_standard", {"standard_id", "standard_code"}, detections);
+    }
+    if (result.success) {
+        result = sql.BatchInsert("acceptance_standard", {"acceptance_id", "acceptance_code"}, acceptances);
+    }
+    if (!result.success && errorMsg) *errorMsg = result.errorMsg;
+    return result.success;
+}
+
+bool SqlFixture::insertProducts(const Options &options, Result &result)
+{
+    static const QStringList columns = {
+        "product_id", "product_name", "job_order_no", "material_grade", "customer_po", "part_no",
+        "product_serial_no", "drawing_no", "part_description", "smelting_furnace_no",
+        "heat_treatment_furnace_no", "heat_treatment_state", "client_name", "quantity", "reviewer_result",
+        "tool_id", "editor_name", "editor_opinion", "reviewer_name", "reviewer_opinion",
+        "standard_id", "acceptance_id", "create_time", "update_time"
+    };
+    QRandomGenerator rng(options.seed);
+    const int blockRows = qMax(1, options.blockRows);
+    auto pick = [&rng](const QStringList& list) { return list.at(int(rng.bounded(quint32(list.size())))); };
+
+    for (int start = 0; start < options.productRows; start += blockRows) {
+        const int end = qMin(options.productRows, start + blockRows);
+        QList<QVariantList> rows;
+        rows.reserve(end - start);
+        for (int i = start; i < end; ++i) {
+            QDateTime createTime = options.startTime.addSecs(qint64(i) * CREATE_INTERVAL_SECS
+                                                             + rng.bounded(CREATE_INTERVAL_SECS));
+            // 约1/10的记录被修改过
+            QVariant updateTime = rng.bounded(10) == 0
+                    ? QVariant(createTime.addSecs(3600 + rng.bounded(7 * 24 * 3600)).toString(DATETIME_FORMAT))
+                    : QVariant(QVariant::String);
+            QString editor = pick(PEOPLE);
+            rows << QVariantList{
+                i + 1,
+                pick(PRODUCT_NAMES),
+                jobOrderNo(i, options.startTime),
+                pick(MATERIALS),
+                QString("PO%1").arg(rng.bounded(100000), 5, 10, QChar('0')),
+                QString("P-%1").arg(rng.bounded(10000), 4, 10, QChar('0')),
+                QString("SN%1").arg(i + 1, 8, 10, QChar('0')),
+                QString("DT-%1").arg(rng.bounded(1000), 3, 10, QChar('0')),
+                QString("尺寸检测零件%1").arg(i % 100),
+                QString("L%1").arg(rng.bounded(1000)),
+                QString("H%1").arg(rng.bounded(100)),
+                pick(HEAT_STATES),
+                pick(CLIENTS),
+                1 + int(rng.bounded(20)),
+                rng.bounded(20) == 0 ? "不合格" : "合格",
+                1 + int(rng.bounded(quint32(qMax(1, options.toolRows)))),
+                editor,
+                "符合要求",
+                pick(PEOPLE),
+                "同意",
+                1 + int(rng.bounded(quint32(qMax(1, options.standardRows)))),
+                1 + int(rng.bounded(quint32(qMax(1, options.standardRows)))),
+                createTime.toString(DATETIME_FORMAT),
+                updateTime
+            };
+        }
+        SqlService::BatchResult batch = SqlService::Get().BatchInsert("product_base_info", columns, rows);
+        result.productRows += batch.affectedRows;
+        if (!batch.success) {
+            result.errorMsg = batch.errorMsg;
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+﻿#ifndef SQLFIXTURE_H
+#define SQLFIXTURE_H
+
+#include <QString>
+#include <QDateTime>
+
+///
+/// \brief 测试数据生成：在SqlService当前连接上重建product_base_info、measurement_tool、
+/// detection_standard、acceptance_standard四张表并写入N行合成数据；同一种子生成的数据完全一致
+/// 会删除同名表，默认只允许在SQLite/内存库上执行
+///
+class SqlFixture
+{
+public:
+    struct Options {
+        int productRows = 1000;        // 产品行数
+        int toolRows = 50;             // 测量工具行数
+        int standardRows = 20;         // 检测标准、验收标准各多少行
+        quint32 seed = 20240101;       // 随机种子
+        QDateTime startTime = QDateTime(QDate(2024, 1, 1), QTime(8, 0)); // 第一条产品的创建时间
+        int blockRows = 10000;         // 每次生成并写入的行数（控制内存占用）
+        bool allowMySql = false;       // 允许在MySQL上重建表
+    };
+
+    struct Result {
+        bool success = false;
+        QString errorMsg;
+        int productRows = 0;           // 已写入的产品行数
+        qint64 elapsedMs = 0;
+    };
+
+    static Result generate(const Options& options);
+
+    // 第index行产品的工作令号（与生成规则一致，便于压测时构造查询条件）
+    static QString jobOrderNo(int index, const QDateTime& startTime = Options().startTime);
+
+private:
+    static bool createTables(QString* errorMsg);
+    static bool insertLookupTables(const Options& options, QString* errorMsg);
+    static bool insertProducts(const Options& options, Result& result);
+};
+
+#endif // SQLFIXTURE_H
@@ -1,5 +1,155 @@
 ﻿#include "sqlservice.h"
 #include<QDebug>
+#include<QElapsedTimer>
+#include"ilogger.h"
+#include<QDir>
+#include<QCoreApplication>
+#include<QDateTime>
+#include<QRegularExpression>
+#include<QRunnable>
+#include<QThreadPool>
+#include<functional>
+
+// 单条预处理语句占位符上限：MySQL 65535，SQLite按旧版本默认值999
+static const int MYSQL_MAX_PLACEHOLDERS = 65535;
+static const int SQLITE_MAX_PLACEHOLDERS = 999;
+// 探活间隔
+static const int PING_INTERVAL_MS = 60 * 1000;
+// 自动重连退避区间
+static const int RECONNECT_MIN_DELAY_MS = 1000;
+static const int RECONNECT_MAX_DELAY_MS = 60 * 1000;
+// 增量拉取时selectSql须选出的水位字段别名
+static const QString DELTA_TIME_FIELD = "delta_time";
+static const QString DELTA_KEY_FIELD = "delta_key";
+// 连接选项：连接超时（秒）
+static const QString CONNECT_OPTIONS = "MYSQL_OPT_CONNECT_TIMEOUT=5";
+// 后台探测连接：连接与读写都只等短时间
+static const QString PROBE_CONNECT_OPTIONS = "MYSQL_OPT_CONNECT_TIMEOUT=5;MYSQL_OPT_READ_TIMEOUT=5;MYSQL_OPT_WRITE_TIMEOUT=5";
+// SQLite连接选项：库被其它连接写锁定时等待（毫秒）；内存库需按URI打开以便各线程连接共享
+static const QString SQLITE_CONNECT_OPTIONS = "QSQLITE_BUSY_TIMEOUT=5000";
+// SQLite中时间按文本存储的格式
+static const QString SQLITE_DATETIME_FORMAT = "yyyy-MM-dd HH:mm:ss";
+static const QString SQLITE_MEMORY_CONNECT_OPTIONS = "QSQLITE_OPEN_URI;QSQLITE_BUSY_TIMEOUT=5000";
+// 本服务写入后该时间内的读操作走主库（规避副本复制延迟）
+static const int READ_AFTER_WRITE_PRIMARY_MS = 2000;
+// 执行超过该时间后断线不再重试：多半是驱动读超时或语句被终止，重试只会再等一轮
+static const int RETRY_MAX_EXEC_MS = 1000;
+// MySQL错误码：3024 语句超过MAX_EXECUTION_TIME
+static const QString MYSQL_QUERY_TIMEOUT_CODE = "3024";
+static const QString QUERY_CANCELLED_MSG = "查询已取消";
+
+// SELECT语句加MAX_EXECUTION_TIME优化器提示（MySQL 5.7.8+按语句在服务器端超时中止，不支持的版本当作注释忽略）
+static QString withExecutionTimeHint(const QString& sql, int timeoutMs)
+{
+    static const QRegularExpression selectRegex("^\\s*SELECT\\b", QRegularExpression::CaseInsensitiveOption);
+    QRegularExpressionMatch match = selectRegex.match(sql);
+    if (!match.hasMatch() || sql.contains("MAX_EXECUTION_TIME", Qt::CaseInsensitive)) return sql;
+    return sql.left(match.capturedEnd()) + QString(" /*+ MAX_EXECUTION_TIME(%1) */").arg(timeoutMs)
+            + sql.mid(match.capturedEnd());
+}
+
+// 可能长时间等待网络的操作（探测服务器等）交给后台线程，不占用调用线程
+class BackgroundTask : public QRunnable
+{
+public:
+    explicit BackgroundTask(std::function<void()> task) : m_task(std::move(task)) {}
+    void run() override { m_task(); }
+
+private:
+    std::function<void()> m_task;
+};
+
+static void runInBackground(std::function<void()> task)
+{
+    // 程序退出时线程池析构，等待进行中的任务结束
+    static QThreadPool pool;
+    pool.start(new BackgroundTask(std::move(task)));
+}
+
+// 用临时连接探测MySQL服务器（连接后执行SELECT 1），连接在调用线程内建立并移除
+static bool probeMySql(const QString& host, int port, const QString& user, const QString& password,
+                       const QString& dbName, QString* errorMsg)
+{
+    const QString connName = QString("SQL_PROBE_%1").arg(reinterpret_cast<quintptr>(QThread::currentThreadId()), 0, 16);
+    bool ok = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QMYSQL", connName);
+        db.setHostName(host);
+        db.setPort(port);
+        db.setUserName(user);
+        db.setPassword(password);
+        db.setDatabaseName(dbName);
+        db.setConnectOptions(PROBE_CONNECT_OPTIONS);
+        if (db.open()) {
+            QSqlQuery query(db);
+            ok = query.exec("SELECT 1");
+            if (!ok && errorMsg) *errorMsg = query.lastError().text();
+        } else if (errorMsg) {
+            *errorMsg = db.lastError().text();
+        }
+    }
+    QSqlDatabase::removeDatabase(connName);
+    return ok;
+}
+
+bool SqlCancelToken::attach(const Target &target)
+{
+    QMutexLocker locker(&m_mutex);
+    if (isCancelled()) return false;
+    m_target = target;
+    m_attached = true;
+    return true;
+}
+
+void SqlCancelToken::detach()
+{
+    QMutexLocker locker(&m_mutex);
+    m_attached = false;
+}
+
+void SqlCancelToken::cancel()
+{
+    if (!m_cancelled.testAndSetOrdered(0, 1)) return;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_attached || m_target.connectionId <= 0) return;
+    }
+    // 旁路连接可能要等到连接超时，交给后台线程，调用线程（多为界面线程）不等待
+    SqlCancelTokenPtr self = sharedFromThis();
+    if (!self) {
+        killQuery();
+        return;
+    }
+    runInBackground([self]() { self->killQuery(); });
+}
+
+void SqlCancelToken::killQuery()
+{
+    QMutexLocker locker(&m_mutex);
+    // 排队期间语句已结束
+    if (!m_attached || m_target.connectionId <= 0) return;
+    // 执行中的连接被占用，另开一条短连接发送KILL QUERY（只终止语句，不断开原连接）
+    const QString connName = QString("SQL_KILL_%1").arg(reinterpret_cast<quintptr>(this), 0, 16);
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QMYSQL", connName);
+        db.setHostName(m_target.host);
+        db.setPort(m_target.port);
+        db.setUserName(m_target.user);
+        db.setPassword(m_target.password);
+        db.setConnectOptions(CONNECT_OPTIONS);
+        if (!db.open()) {
+            LOG_WARN(QString("取消查询失败：无法连接%1:%2：%3").arg(m_target.host).arg(m_target.port).arg(db.lastError().text()));
+        } else {
+            QSqlQuery query(db);
+            if (query.exec(QString("KILL QUERY %1").arg(m_target.connectionId))) {
+                LOG_INFO(QString("已终止服务器端查询（连接%1）").arg(m_target.connectionId));
+            } else {
+                LOG_WARN(QString("取消查询失败：%1").arg(query.lastError().text()));
+            }
+        }
+    }
+    QSqlDatabase::removeDatabase(connName);
+}
 
 SqlService::SqlService()
 {
@@ -12,8 +162,19 @@ SqlService::SqlService()
     {
         m_db = QSqlDatabase::addDatabase("QMYSQL", connName);
     }
+    QString readConnName = connName + "_R";
+    m_readDb = QSqlDatabase::contains(readConnName) ? QSqlDatabase::database(readConnName, false)
+                                                    : QSqlDatabase::addDatabase("QMYSQL", readConnName);
     // 初始状态为未连接
     m_isConnected = false;
+
+    // 连接监控：定时探活，断线后按指数退避自动重连
+    m_pingTimer = new QTimer(this);
+    m_pingTimer->setInterval(PING_INTERVAL_MS);
+    connect(m_pingTimer, &QTimer::timeout, this, &SqlService::onPingTimeout);
+    m_reconnectTimer = new QTimer(this);
+    m_reconnectTimer->setSingleShot(true);
+    connect(m_reconnectTimer, &QTimer::timeout, this, &SqlService::onReconnectTimeout);
 }
 
 SqlService::~SqlService()
@@ -22,22 +183,37 @@ SqlService::~SqlService()
     if (m_isConnected && m_db.isOpen()) {
         m_db.close();
     }
+    if (m_readDb.isOpen()) {
+        m_readDb.close();
+    }
+    removeThreadConnections();
     // 移除连接
-    QString connName = getUniqueConnName();
+    QString connName = m_db.connectionName();
+    QString readConnName = m_readDb.connectionName();
+    m_db = QSqlDatabase();
+    m_readDb = QSqlDatabase();
     if (QSqlDatabase::contains(connName)) {
         QSqlDatabase::removeDatabase(connName);
 
     }
+    if (QSqlDatabase::contains(readConnName)) {
+        QSqlDatabase::removeDatabase(readConnName);
+    }
     try {
-           MysqlConfig& mysqlConfig = ConfigManager::Get().getConfig<MysqlConfig>();
-           // 更新ConfigManager中的配置（与SqlService一致）
-           mysqlConfig.setHost(m_host);
-           mysqlConfig.setPort(m_port);
-           mysqlConfig.setUsername(m_user);
-           mysqlConfig.setPassword(m_password);
-           mysqlConfig.setDbName(m_dbName);
-           // 立即保存所有配置到ini文件
-           ConfigManager::Get().saveAllConfig();
+           // 更新ConfigManager中的配置（与SqlService一致），无变化时不写文件
+           std::shared_ptr<const MysqlConfig> current = ConfigManager::Get().snapshot<MysqlConfig>();
+           if (current->getHost() != m_host || current->getPort() != m_port || current->getUsername() != m_user
+                   || current->getPassword() != m_password || current->getDbName() != m_dbName) {
+               ConfigManager::Get().update<MysqlConfig>([this](MysqlConfig& mysqlConfig) {
+                   mysqlConfig.setHost(m_host);
+                   mysqlConfig.setPort(m_port);
+                   mysqlConfig.setUsername(m_user);
+                   mysqlConfig.setPassword(m_password);
+                   mysqlConfig.setDbName(m_dbName);
+               });
+               // 退出阶段事件循环已停止，直接写入
+               ConfigManager::Get().flush();
+           }
        } catch (const std::runtime_error& e) {
            m_lastError = QString("同步配置到ConfigManager失败：%1").arg(e.what());
            qWarning() << m_lastError;
@@ -54,50 +230,545 @@ void SqlService::setConfig(const BaseMysqlConfig &config)
     m_user = config.getUsername();
     m_password = config.getPassword();
     m_dbName = config.getDbName();
+    m_readHost = config.hasReadReplica() ? config.getReadHost() : QString();
+    m_readPort = config.getReadPort();
+    {
+        QMutexLocker driverLocker(&m_driverMutex);
+        m_driver = config.getDriver();
+    }
+    m_sqlStats.setSlowThresholdMs(config.getSlowQueryMs());
+    m_queryTimeoutMs = config.getQueryTimeoutMs();
+    m_lockWaitMs.storeRelease(config.getLockWaitMs());
+    m_readTimeoutSec = config.getReadTimeoutSec();
+}
+
+bool SqlService::applyConfig(const BaseMysqlConfig &config)
+{
+    bool connectionChanged = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        const QString readHost = config.hasReadReplica() ? config.getReadHost() : QString();
+        connectionChanged = m_host != config.getHost() || m_port != config.getPort()
+                || m_user != config.getUsername() || m_password != config.getPassword()
+                || m_dbName != config.getDbName() || m_driver != config.getDriver()
+                || m_readHost != readHost || m_readPort != config.getReadPort()
+                || m_readTimeoutSec != config.getReadTimeoutSec();
+    }
+    setConfig(config);
+    if (!connectionChanged || !m_wantConnected) {
+        LOG_INFO("数据库配置已更新");
+        return false;
+    }
+    LOG_INFO("数据库连接参数已变化，按新配置重连");
+    connectDbAsync();
+    return true;
 }
 
 bool SqlService::connectDb()
 {
-    QMutexLocker locker(&m_mutex);
+    return openConnection(true);
+}
+
+void SqlService::connectDbAsync()
+{
+    if (!isMySql()) {
+        connectDb();
+        return;
+    }
+    m_wantConnected = true;
+    if (!startProbe(Probe::Connect)) {
+        notifyStateChanged(false);
+    }
+}
+
+bool SqlService::openConnection(bool withReplica)
+{
+    // 重连后表结构可能已变化，清空缓存
+    invalidateSchemaCache();
+    bool ok = false;
+    {
+        std::unique_lock<QMutex> locker(m_mutex, std::defer_lock);
+        QString lockError;
+        if (!lockService(locker, -1, &lockError)) {
+            LOG_WARN(QString("连接数据库失败：%1").arg(lockError));
+            return false;
+        }
+        m_wantConnected = true;
+        // 可能连到了另一台服务器，缓存结果不再可信
+        m_queryCache.clear();
+        ok = openLocked(withReplica);
+    }
+    notifyStateChanged(ok);
+    return ok;
+}
+
+void SqlService::disconnectDb()
+{
+    invalidateSchemaCache();
+    // 主动断开：不再自动重连
+    m_wantConnected = false;
+    {
+        std::unique_lock<QMutex> locker(m_mutex, std::defer_lock);
+        QString lockError;
+        if (!lockService(locker, -1, &lockError)) {
+            LOG_WARN(QString("断开数据库失败：%1").arg(lockError));
+            return;
+        }
+        // 若已连接，关闭数据库
+        if (m_isConnected && m_db.isOpen()) {
+            m_db.close();
+            m_lastError.clear();
+        }
+        if (m_readDb.isOpen()) {
+            m_readDb.close();
+        }
+        m_replicaAvailable = false;
+        removeThreadConnections();
+        // 重置连接状态
+        m_isConnected = false;
+    }
+    notifyStateChanged(false);
+}
+
+bool SqlService::openLocked(bool withReplica)
+{
     // 若已连接，先断开
-    if (m_isConnected && m_db.isOpen()) {
+    if (m_db.isOpen()) {
         m_db.close();
-        m_isConnected = false;
     }
+    m_isConnected = false;
+    m_connectionIds.clear();
+    // 工作线程连接按旧配置克隆，需一并移除
+    removeThreadConnections();
+    ensureDriverLocked();
     // 加载当前配置到数据库连接对象
-    m_db.setHostName(m_host);
-    m_db.setPort(m_port);
-    m_db.setUserName(m_user);
-    m_db.setPassword(m_password);
-    m_db.setDatabaseName(m_dbName);
+    if (m_driver == BaseMysqlConfig::DRIVER_MYSQL) {
+        m_db.setHostName(m_host);
+        m_db.setPort(m_port);
+        m_db.setUserName(m_user);
+        m_db.setPassword(m_password);
+        m_db.setDatabaseName(m_dbName);
+        // 连接与读写超时，避免服务器不可达或无响应时长时间阻塞
+        m_db.setConnectOptions(mysqlConnectOptions());
+    } else {
+        m_db.setDatabaseName(sqliteDatabaseName());
+        m_db.setConnectOptions(m_driver == BaseMysqlConfig::DRIVER_MEMORY ? SQLITE_MEMORY_CONNECT_OPTIONS
+                                                                          : SQLITE_CONNECT_OPTIONS);
+    }
     // 执行连接
     if (!m_db.open()) {
         m_lastError = m_db.lastError().text();
-        m_isConnected = false;
         return false;
     }
     // 连接成功
     m_isConnected = true;
     m_lastError.clear();
+    // 副本失败不影响主库连接结果
+    if (withReplica) {
+        openReplicaLocked();
+    } else {
+        if (m_readDb.isOpen()) m_readDb.close();
+        m_replicaAvailable = false;
+    }
     return true;
 }
 
-void SqlService::disconnectDb()
+bool SqlService::openReplicaLocked()
+{
+    if (m_readDb.isOpen()) {
+        m_readDb.close();
+    }
+    m_replicaAvailable = false;
+    m_connectionIds.remove(m_readDb.connectionName());
+    // 读写分离只对MySQL生效
+    if (m_readHost.isEmpty() || m_driver != BaseMysqlConfig::DRIVER_MYSQL) return false;
+
+    m_readDb.setHostName(m_readHost);
+    m_readDb.setPort(m_readPort);
+    m_readDb.setUserName(m_user);
+    m_readDb.setPassword(m_password);
+    m_readDb.setDatabaseName(m_dbName);
+    m_readDb.setConnectOptions(mysqlConnectOptions());
+    if (!m_readDb.open()) {
+        LOG_WARN(QString("只读副本%1:%2连接失败，读操作改走主库：%3")
+                 .arg(m_readHost).arg(m_readPort).arg(m_readDb.lastError().text()));
+        return false;
+    }
+    m_replicaAvailable = true;
+    LOG_INFO(QString("只读副本%1:%2已连接，查询走副本").arg(m_readHost).arg(m_readPort));
+    return true;
+}
+
+void SqlService::ensureDriverLocked()
+{
+    const QString qtDriver = (m_driver == BaseMysqlConfig::DRIVER_MYSQL) ? "QMYSQL" : "QSQLITE";
+    if (m_db.driverName() == qtDriver) return;
+    QString connName = m_db.connectionName();
+    QString readConnName = m_readDb.connectionName();
+    if (m_readDb.isOpen()) {
+        m_readDb.close();
+    }
+    m_replicaAvailable = false;
+    m_db = QSqlDatabase();
+    m_readDb = QSqlDatabase();
+    QSqlDatabase::removeDatabase(connName);
+    QSqlDatabase::removeDatabase(readConnName);
+    m_db = QSqlDatabase::addDatabase(qtDriver, connName);
+    m_readDb = QSqlDatabase::addDatabase(qtDriver, readConnName);
+    if (!m_db.isValid()) {
+        LOG_ERROR(QString("数据库驱动%1不可用，可用驱动：%2").arg(qtDriver).arg(QSqlDatabase::drivers().join(",")));
+    }
+}
+
+QString SqlService::sqliteDatabaseName() const
+{
+    if (m_driver == BaseMysqlConfig::DRIVER_MEMORY) {
+        // 同名共享缓存内存库：同一进程内各线程连接看到同一份数据，最后一个连接关闭后释放
+        return QString("file:%1?mode=memory&cache=shared").arg(m_dbName);
+    }
+    QString fileName = m_dbName.endsWith(".db", Qt::CaseInsensitive) ? m_dbName : m_dbName + ".db";
+    return QDir(QCoreApplication::applicationDirPath()).absoluteFilePath(fileName);
+}
+
+QString SqlService::driver() const
+{
+    QMutexLocker locker(&m_driverMutex);
+    return m_driver;
+}
+
+QString SqlService::mysqlConnectOptions() const
+{
+    if (m_readTimeoutSec <= 0) return CONNECT_OPTIONS;
+    // 驱动读超时内部会重试，实际等待约为设定值的3倍
+    return QString("%1;MYSQL_OPT_READ_TIMEOUT=%2;MYSQL_OPT_WRITE_TIMEOUT=%2").arg(CONNECT_OPTIONS).arg(m_readTimeoutSec);
+}
+
+bool SqlService::lockService(std::unique_lock<QMutex> &locker, int waitMs, QString *errorMsg)
+{
+    if (waitMs < 0) waitMs = m_lockWaitMs.loadAcquire();
+    if (waitMs == 0) {
+        locker.lock();
+        return true;
+    }
+    if (!m_mutex.tryLock(waitMs)) {
+        if (errorMsg) *errorMsg = QString("数据库繁忙：等待其它数据库操作超过%1ms").arg(waitMs);
+        return false;
+    }
+    locker = std::unique_lock<QMutex>(m_mutex, std::adopt_lock);
+    return true;
+}
+
+qint64 SqlService::connectionIdLocked(QSqlDatabase &db)
+{
+    auto it = m_connectionIds.constFind(db.connectionName());
+    if (it != m_connectionIds.constEnd()) return it.value();
+    QSqlQuery query(db);
+    if (!query.exec("SELECT CONNECTION_ID()") || !query.next()) return 0;
+    qint64 id = query.value(0).toLongLong();
+    m_connectionIds.insert(db.connectionName(), id);
+    return id;
+}
+
+bool SqlService::isMySql() const
+{
+    return driver() == BaseMysqlConfig::DRIVER_MYSQL;
+}
+
+QString SqlService::dateTimeExpr(const QString &column) const
+{
+    if (isMySql()) {
+        return QString("DATE_FORMAT(%1, '%Y-%m-%d %H:%i:%s')").arg(column);
+    }
+    return QString("strftime('%Y-%m-%d %H:%M:%S', %1)").arg(column);
+}
+
+QString SqlService::likeEscapeClause() const
+{
+    // MySQL默认以反斜杠转义；SQLite需显式指定
+    return isMySql() ? QString() : QString(" ESCAPE '\\'");
+}
+
+void SqlService::markReplicaDownLocked(const QString &reason)
+{
+    if (!m_replicaAvailable) return;
+    m_replicaAvailable = false;
+    LOG_WARN(QString("只读副本不可用，读操作回落主库：%1").arg(reason));
+}
+
+bool SqlService::isReplicaAvailable()
 {
     QMutexLocker locker(&m_mutex);
-    // 若已连接，关闭数据库
-    if (m_isConnected && m_db.isOpen()) {
-        m_db.close();
-        m_lastError.clear();
+    return m_replicaAvailable;
+}
+
+bool SqlService::isConnectionLost(const QSqlError &error)
+{
+    // 2006: server has gone away  2013: lost connection during query
+    // 2055: lost connection (system error)  2002/2003: can't connect
+    static const QStringList lostCodes = {"2006", "2013", "2055", "2002", "2003"};
+    return error.type() == QSqlError::ConnectionError || lostCodes.contains(error.nativeErrorCode());
+}
+
+bool SqlService::handleConnectionLostLocked(QSqlDatabase &db, const QSqlError &error, bool tryReopen)
+{
+    if (!isConnectionLost(error)) return false;
+    m_connectionIds.remove(db.connectionName());
+    LOG_WARN(QString("数据库连接已断开：%1").arg(error.text()));
+    if (tryReopen) {
+        db.close();
+        if (db.open()) {
+            // 与重连一致：服务器端表结构可能已在断开期间变更
+            invalidateSchemaCache();
+            LOG_INFO("数据库连接已恢复");
+            return true;
+        }
     }
-    // 重置连接状态
-    m_isConnected = false;
+    // 主连接不可用：标记断开，交给监控定时器退避重连
+    if (m_isConnected) {
+        m_isConnected = false;
+        m_lastError = error.text();
+        notifyStateChanged(false);
+    }
+    return false;
+}
+
+void SqlService::notifyStateChanged(bool connected)
+{
+    // 统一排队到服务所在线程：定时器只能在所属线程启停，也避免持锁时直接回调
+    QMetaObject::invokeMethod(this, [this, connected]() {
+        const bool wantConnected = m_wantConnected;
+        if (connected) {
+            m_reconnectTimer->stop();
+            m_reconnectDelayMs = RECONNECT_MIN_DELAY_MS;
+            m_pingTimer->start();
+        } else {
+            m_pingTimer->stop();
+            if (wantConnected && !m_reconnectTimer->isActive()) {
+                m_reconnectTimer->start(m_reconnectDelayMs);
+            } else if (!wantConnected) {
+                m_reconnectTimer->stop();
+            }
+        }
+        emit connectionStateChanged(connected);
+    }, Qt::QueuedConnection);
+}
+
+void SqlService::onPingTimeout()
+{
+    // 探活在后台线程用临时连接进行：连接半断时SELECT 1要等到读超时（驱动还会重试），不能占用界面线程。
+    // 主连接因空闲被服务器断开时，下次执行语句会就地重开；本地SQLite无需探活
+    if (!m_isConnected || !isMySql() || m_probeCount > 0) return;
+    startProbe(Probe::Ping);
+}
+
+void SqlService::onReconnectTimeout()
+{
+    if (!m_wantConnected || m_isConnected) return;
+    if (!isMySql()) {
+        reconnect(true);
+        return;
+    }
+    // 服务器不可达时连接要等到超时：先在后台探测，可用后再打开
+    if (m_probeCount > 0 || !startProbe(Probe::Reconnect)) {
+        m_reconnectTimer->start(m_reconnectDelayMs);
+    }
+}
+
+void SqlService::reconnect(bool withReplica)
+{
+    bool ok = false;
+    {
+        std::unique_lock<QMutex> locker(m_mutex, std::try_to_lock);
+        if (!m_wantConnected || m_isConnected) return;
+        if (!locker.owns_lock()) {
+            // 连接正被占用，稍后再试
+            m_reconnectTimer->start(m_reconnectDelayMs);
+            return;
+        }
+        ok = openLocked(withReplica);
+    }
+    if (ok) {
+        LOG_INFO("数据库自动重连成功");
+        invalidateSchemaCache();
+        notifyStateChanged(true);
+        return;
+    }
+    scheduleReconnect(lastError());
 }
 
+void SqlService::scheduleReconnect(const QString &error)
+{
+    m_reconnectDelayMs = qMin(m_reconnectDelayMs * 2, RECONNECT_MAX_DELAY_MS);
+    LOG_WARN(QString("数据库自动重连失败，%1秒后重试：%2").arg(m_reconnectDelayMs / 1000).arg(error));
+    m_reconnectTimer->start(m_reconnectDelayMs);
+}
+
+bool SqlService::startProbe(Probe purpose)
+{
+    QString host, user, password, dbName, readHost;
+    int port = 0;
+    int readPort = 0;
+    {
+        // 用户发起的连接按常规等锁；定时发起的探测不等待，下一轮再试
+        std::unique_lock<QMutex> locker(m_mutex, std::defer_lock);
+        QString lockError;
+        const bool locked = purpose == Probe::Connect ? lockService(locker, -1, &lockError) : locker.try_lock();
+        if (!locked) {
+            if (purpose == Probe::Connect) {
+                LOG_WARN(QString("连接数据库失败：%1").arg(lockError));
+            }
+            return false;
+        }
+        host = m_host;
+        port = m_port;
+        user = m_user;
+        password = m_password;
+        dbName = m_dbName;
+        readHost = m_readHost;
+        readPort = m_readPort;
+    }
+    ++m_probeCount;
+    runInBackground([this, purpose, host, port, user, password, dbName, readHost, readPort]() {
+        ProbeResult result;
+        result.reachable = probeMySql(host, port, user, password, dbName, &result.error);
+        if (!readHost.isEmpty()) {
+            result.replicaReachable = probeMySql(readHost, readPort, user, password, dbName, &result.replicaError);
+        }
+        QMetaObject::invokeMethod(this, [this, purpose, result]() {
+            onProbeFinished(purpose, result);
+        }, Qt::QueuedConnection);
+    });
+    return true;
+}
+
+void SqlService::onProbeFinished(Probe purpose, const ProbeResult &result)
+{
+    --m_probeCount;
+    // 探测期间已主动断开
+    if (!m_wantConnected) return;
+    if (purpose != Probe::Ping && result.reachable && !result.replicaError.isEmpty()) {
+        LOG_WARN(QString("只读副本%1:%2不可达，读操作改走主库：%3").arg(m_readHost).arg(m_readPort).arg(result.replicaError));
+    }
+    switch (purpose) {
+    case Probe::Connect:
+        if (result.reachable) {
+            openConnection(result.replicaReachable);
+            return;
+        }
+        {
+            // 与连接失败时一致：原连接已不对应当前配置
+            std::unique_lock<QMutex> locker(m_mutex, std::defer_lock);
+            if (lockService(locker, -1, nullptr)) {
+                if (m_db.isOpen()) m_db.close();
+                if (m_readDb.isOpen()) m_readDb.close();
+                m_replicaAvailable = false;
+                removeThreadConnections();
+                m_isConnected = false;
+                m_lastError = result.error;
+            }
+        }
+        notifyStateChanged(false);
+        return;
+    case Probe::Reconnect:
+        if (m_isConnected) return;
+        if (result.reachable) {
+            reconnect(result.replicaReachable);
+        } else {
+            scheduleReconnect(result.error);
+        }
+        return;
+    case Probe::Ping: {
+        // 只做状态变更，不等待执行中的语句
+        std::unique_lock<QMutex> locker(m_mutex, std::try_to_lock);
+        if (!locker.owns_lock() || !m_isConnected) return;
+        if (!result.reachable) {
+            // 服务器不可用：标记断开，交给重连定时器（重连前同样先探测）
+            LOG_WARN(QString("数据库连接已断开：%1").arg(result.error));
+            m_isConnected = false;
+            m_lastError = result.error;
+            m_connectionIds.clear();
+            notifyStateChanged(false);
+            return;
+        }
+        // 副本：可用时确认仍可达，不可用时在探测可达后恢复
+        if (m_readHost.isEmpty()) return;
+        if (m_replicaAvailable && !result.replicaReachable) {
+            markReplicaDownLocked(result.replicaError);
+        } else if (!m_replicaAvailable && result.replicaReachable) {
+            openReplicaLocked();
+        }
+        return;
+    }
+    }
+}
+
+QString SqlService::lastError() const
+{
+    if (!m_mutex.tryLock(m_lockWaitMs.loadAcquire())) return "数据库繁忙";
+    std::unique_lock<QMutex> locker(m_mutex, std::adopt_lock);
+    return m_lastError;
+}
+
+QSqlDatabase SqlService::database(Route route)
+{
+    QSqlDatabase& mainDb = (route == Route::Replica) ? m_readDb : m_db;
+    // 主线程直接使用主连接
+    if (QThread::currentThread() == thread()) {
+        return mainDb;
+    }
+    // QSqlDatabase不能跨线程使用：工作线程按主连接配置克隆独立连接，只在本线程内打开、关闭和移除
+    ThreadConnections* connections = m_threadConnections.localData();
+    if (!connections) {
+        connections = new ThreadConnections;
+        connections->owner = this;
+        connections->generation = m_connectionGeneration;
+        m_threadConnections.setLocalData(connections);
+    } else if (connections->generation != m_connectionGeneration) {
+        connections->removeLocked();
+        connections->generation = m_connectionGeneration;
+    }
+    QString& connName = connections->names[route == Route::Replica ? 1 : 0];
+    if (connName.isEmpty()) {
+        // 连接名不复用，线程号被新线程复用时也不会取到旧连接的服务器线程号
+        static QAtomicInt sequence;
+        connName = QString("%1_T%2").arg(mainDb.connectionName()).arg(sequence.fetchAndAddRelaxed(1));
+        QSqlDatabase::cloneDatabase(mainDb, connName);
+    }
+    QSqlDatabase db = QSqlDatabase::database(connName, false);
+    if (m_isConnected && !db.isOpen()) {
+        m_connectionIds.remove(connName);
+        if (!db.open()) m_lastError = db.lastError().text();
+    }
+    return db;
+}
+
+void SqlService::removeThreadConnections()
+{
+    ++m_connectionGeneration;
+}
+
+SqlService::ThreadConnections::~ThreadConnections()
+{
+    QMutexLocker locker(&owner->m_mutex);
+    removeLocked();
+}
+
+void SqlService::ThreadConnections::removeLocked()
+{
+    for (QString& connName : names) {
+        if (connName.isEmpty()) continue;
+        {
+            QSqlDatabase db = QSqlDatabase::database(connName, false);
+            if (db.isOpen()) db.close();
+        }
+        QSqlDatabase::removeDatabase(connName);
+        owner->m_connectionIds.remove(connName);
+        connName.clear();
+    }
+}
 
 bool SqlService::isAvailable()
 {
-    QMutexLocker locker(&m_mutex);
     return m_isConnected;
 }
 
@@ -105,24 +776,42 @@ SqlService::QueryResult SqlService::NonQuery(const QString &sql, const QList<QVa
 {
     QueryResult result;
     result.success = false;
-    QMutexLocker locker(&m_mutex);
-    if (!m_isConnected || !m_db.isOpen()) {
+    std::unique_lock<QMutex> locker(m_mutex, std::defer_lock);
+    if (!lockService(locker, -1, &result.errorMsg)) return result;
+    QSqlDatabase db = database();
+    if (!m_isConnected || !db.isOpen()) {
         result.errorMsg = "数据库未连接";
         return result;
     }
-    QSqlQuery query(m_db);
+    SqlStats::Sample sample;
+    QElapsedTimer timer;
+    timer.start();
+    QSqlQuery query(db);
     // 准备SQL（支持参数绑定）
     if (!query.prepare(sql)) {
         result.errorMsg = QString("SQL准备失败：%1（SQL：%2）").arg(query.lastError().text()).arg(sql);
+        sample.prepareUs = timer.nsecsElapsed() / 1000;
+        sample.success = false;
+        m_sqlStats.record(sql, sample);
         return result;
     }
     // 绑定参数（替换?占位符）
     for (int i = 0; i < params.size(); ++i) {
         query.bindValue(i, params[i]);
     }
+    sample.prepareUs = timer.nsecsElapsed() / 1000;
 
     // 执行SQL
-    if (!query.exec()) {
+    timer.restart();
+    bool ok = query.exec();
+    sample.execUs = timer.nsecsElapsed() / 1000;
+    sample.success = ok;
+    sample.rows = ok ? query.numRowsAffected() : 0;
+    m_sqlStats.record(sql, sample);
+    invalidateCacheForWrite(sql);
+    if (!ok) {
+        // 写操作不自动重试，避免重复执行
+        handleConnectionLostLocked(db, query.lastError(), false);
         result.errorMsg = QString("NonQuery执行失败：%1（SQL：%2）").arg(query.lastError().text()).arg(sql);
         return result;
     }
@@ -137,13 +826,25 @@ SqlService::QueryResult SqlService::NonQuery(const QString &sql)
 {
     QueryResult result;
     result.success = false;
-    QMutexLocker locker(&m_mutex);
-    if (!m_isConnected || !m_db.isOpen()) {
+    std::unique_lock<QMutex> locker(m_mutex, std::defer_lock);
+    if (!lockService(locker, -1, &result.errorMsg)) return result;
+    QSqlDatabase db = database();
+    if (!m_isConnected || !db.isOpen()) {
         result.errorMsg = "数据库未连接";
         return result;
     }
-    QSqlQuery query(m_db);
-    if (!query.exec(sql)) {
+    QElapsedTimer timer;
+    timer.start();
+    QSqlQuery query(db);
+    bool ok = query.exec(sql);
+    SqlStats::Sample sample;
+    sample.execUs = timer.nsecsElapsed() / 1000;
+    sample.success = ok;
+    sample.rows = ok ? query.numRowsAffected() : 0;
+    m_sqlStats.record(sql, sample);
+    invalidateCacheForWrite(sql);
+    if (!ok) {
+        handleConnectionLostLocked(db, query.lastError(), false);
         result.errorMsg = QString("NonQuery执行失败：%1（SQL：%2）").arg(query.lastError().text()).arg(sql);
         return result;
     }
@@ -155,32 +856,577 @@ SqlService::QueryResult SqlService::NonQuery(const QString &sql)
 }
 
 SqlService::QueryResult SqlService::GetData(const QString &sql)
+{
+    return execRead(sql, QList<QVariant>(), false);
+}
+
+SqlService::QueryResult SqlService::GetData(const QString &sql, const QList<QVariant> &params)
+{
+    return execRead(sql, params, true);
+}
+
+SqlService::QueryResult SqlService::GetData(const QString &sql, const QList<QVariant> &params,
+                                            const QueryOptions &options)
+{
+    return execRead(sql, params, !params.isEmpty(), options);
+}
+
+SqlService::QueryResult SqlService::execRead(const QString &sql, const QList<QVariant> &params, bool prepared,
+                                             const QueryOptions &options)
 {
     QueryResult result;
     result.success = false;
-    QMutexLocker locker(&m_mutex);
-    if (!m_isConnected || !m_db.isOpen()) {
-        result.errorMsg = "数据库未连接";
+    SqlCancelToken* cancel = options.cancel.data();
+    if (cancel && cancel->isCancelled()) {
+        result.errorMsg = QUERY_CANCELLED_MSG;
+        return result;
+    }
+    std::unique_lock<QMutex> locker(m_mutex, std::defer_lock);
+    if (!lockService(locker, options.lockWaitMs, &result.errorMsg)) return result;
+    const bool mysql = (m_driver == BaseMysqlConfig::DRIVER_MYSQL);
+    const int timeoutMs = options.timeoutMs < 0 ? m_queryTimeoutMs : options.timeoutMs;
+    const QString execSql = (mysql && timeoutMs > 0) ? withExecutionTimeHint(sql, timeoutMs) : sql;
+    // 读操作幂等：连接断开时重连后重试一次
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        // 副本可用且本服务近期没有写入时走副本
+        bool useReplica = m_replicaAvailable
+                && (!m_lastWriteTimer.isValid() || m_lastWriteTimer.elapsed() > READ_AFTER_WRITE_PRIMARY_MS);
+        QSqlDatabase db = database(useReplica ? Route::Replica : Route::Primary);
+        if (useReplica && !db.isOpen()) {
+            markReplicaDownLocked(db.lastError().text());
+            useReplica = false;
+            db = database(Route::Primary);
+        }
+        if (!m_isConnected || !db.isOpen()) {
+            result.errorMsg = "数据库未连接";
+            return result;
+        }
+        if (cancel) {
+            // 登记执行中的连接，cancel()据此KILL QUERY；SQLite只能在读取结果时停止
+            SqlCancelToken::Target target;
+            if (mysql) {
+                target.host = useReplica ? m_readHost : m_host;
+                target.port = useReplica ? m_readPort : m_port;
+                target.user = m_user;
+                target.password = m_password;
+                target.connectionId = connectionIdLocked(db);
+            }
+            if (!cancel->attach(target)) {
+                result.errorMsg = QUERY_CANCELLED_MSG;
+                return result;
+            }
+        }
+        SqlStats::Sample sample;
+        QElapsedTimer timer;
+        timer.start();
+        QSqlQuery query(db);
+        query.setForwardOnly(true); // 只顺序读取，避免驱动缓存整张结果集
+        bool ok = false;
+        if (prepared) {
+            ok = query.prepare(execSql);
+            if (ok) {
+                for (int i = 0; i < params.size(); ++i) {
+                    query.bindValue(i, params[i]);
+                }
+            }
+            sample.prepareUs = timer.nsecsElapsed() / 1000;
+            timer.restart();
+            if (ok) ok = query.exec();
+        } else {
+            ok = query.exec(execSql);
+        }
+        sample.execUs = timer.nsecsElapsed() / 1000;
+        if (ok) {
+            timer.restart();
+            sample.bytes = fetchRows(query, result, cancel);
+            sample.fetchUs = timer.nsecsElapsed() / 1000;
+            sample.rows = result.data.size();
+        }
+        const bool cancelled = cancel && cancel->isCancelled();
+        if (cancel) cancel->detach();
+        if (cancelled) {
+            ok = false;
+            result.data.clear();
+        }
+        sample.success = ok;
+        m_sqlStats.record(sql, sample);
+        if (ok) {
+            // 4. 查询成功
+            result.success = true;
+            result.errorMsg = "";
+            return result;
+        }
+        if (cancelled) {
+            result.errorMsg = QUERY_CANCELLED_MSG;
+            return result;
+        }
+        const QSqlError error = query.lastError();
+        if (error.nativeErrorCode() == MYSQL_QUERY_TIMEOUT_CODE) {
+            result.errorMsg = QString("查询超时：执行超过%1ms（SQL：%2）").arg(timeoutMs).arg(sql);
+            return result;
+        }
+        result.errorMsg = QString("GetData执行失败：%1（SQL：%2）").arg(error.text()).arg(sql);
+        // 长时间执行后断线多为读超时，不再重试以免再等一轮
+        const bool retryable = sample.execUs / 1000 < RETRY_MAX_EXEC_MS;
+        if (useReplica && isConnectionLost(error)) {
+            // 副本断开：本次改走主库重试
+            markReplicaDownLocked(error.text());
+            if (retryable) continue;
+            break;
+        }
+        if (!(handleConnectionLostLocked(db, error, true) && attempt == 0 && retryable)) {
+            break;
+        }
+    }
+    return result;
+}
+
+SqlService::QueryResult SqlService::GetDataCached(const QString &sql, const QList<QVariant> &params, int ttlMs)
+{
+    QString key = QueryCache::makeKey(sql, params);
+    QueryResult result;
+    if (m_queryCache.lookup(key, &result.data)) {
+        result.success = true;
         return result;
     }
-    QSqlQuery query(m_db);
-    if (!query.exec(sql)) {
-        result.errorMsg = QString("GetData执行失败：%1（SQL：%2）").arg(query.lastError().text()).arg(sql);
+    quint64 generation = m_queryCache.generation();
+    result = params.isEmpty() ? GetData(sql) : GetData(sql, params);
+    if (result.success) {
+        m_queryCache.insert(key, result.data, QueryCache::tablesRead(sql), generation, ttlMs);
+    }
+    return result;
+}
+
+SqlService::QueryResult SqlService::GetDelta(const QString &selectSql, const QString &changeExpr,
+                                             const QString &keyExpr, DeltaCursor &cursor, int limit,
+                                             const QueryOptions &options)
+{
+    QString sql = selectSql;
+    QList<QVariant> params;
+    if (!cursor.isStart()) {
+        // SQLite按文本比较时间：按库中存储格式绑定
+        QVariant changeTime = cursor.changeTime;
+        if (changeTime.type() == QVariant::DateTime && !isMySql()) {
+            changeTime = changeTime.toDateTime().toString(SQLITE_DATETIME_FORMAT);
+        }
+        sql += QString(" WHERE (%1 > ? OR (%1 = ? AND %2 > ?))").arg(changeExpr, keyExpr);
+        params << changeTime << changeTime << cursor.key;
+    }
+    sql += QString(" ORDER BY %1 ASC, %2 ASC LIMIT %3").arg(changeExpr, keyExpr).arg(qMax(1, limit));
+    QueryResult result = GetData(sql, params, options);
+    if (!result.success || result.data.isEmpty()) {
         return result;
     }
+    const QVariantMap& last = result.data.last();
+    cursor.changeTime = last.value(DELTA_TIME_FIELD);
+    cursor.key = last.value(DELTA_KEY_FIELD).toLongLong();
+    if (cursor.changeTime.type() == QVariant::String) {
+        QDateTime time = QDateTime::fromString(cursor.changeTime.toString(), SQLITE_DATETIME_FORMAT);
+        if (time.isValid()) cursor.changeTime = time;
+    }
+    for (QVariantMap& row : result.data) {
+        row.remove(DELTA_TIME_FIELD);
+        row.remove(DELTA_KEY_FIELD);
+    }
+    return result;
+}
+
+void SqlService::invalidateCacheForWrite(const QString &sql)
+{
+    m_lastWriteTimer.start();
+    QSet<QString> tables = QueryCache::tablesWritten(sql);
+    if (tables.isEmpty()) {
+        m_queryCache.clear();
+    } else {
+        m_queryCache.invalidateTables(tables);
+    }
+}
+
+qint64 SqlService::fetchRows(QSqlQuery &query, QueryResult &result, const SqlCancelToken *cancel)
+{
+    qint64 bytes = 0;
     QSqlRecord record = query.record(); // 获取字段名信息
+    const int fieldCount = record.count();
+    QStringList fieldNames;
+    for (int i = 0; i < fieldCount; ++i) {
+        fieldNames.append(record.fieldName(i));
+    }
     while (query.next()) {
+        // 每256行检查一次取消
+        if (cancel && (result.data.size() & 0xFF) == 0 && cancel->isCancelled()) break;
         QVariantMap rowMap;
         // 遍历所有字段，按字段名存储值
-        for (int i = 0; i < record.count(); ++i) {
-            QString fieldName = record.fieldName(i);
-            QVariant fieldValue = query.value(i);
-            rowMap.insert(fieldName, fieldValue);
+        for (int i = 0; i < fieldCount; ++i) {
+            QVariant value = query.value(i);
+            bytes += value.type() == QVariant::String ? value.toString().size() * 2 : 8;
+            rowMap.insert(fieldNames[i], value);
         }
         result.data.append(rowMap);
     }
-       // 4. 查询成功
-    result.success = true;
-    result.errorMsg = "";
+    return bytes;
+}
+
+
+QString SqlService::buildMultiRowInsertSql(const QString &tableName, const QStringList &columns, int count, bool upsert) const
+{
+    const bool mysql = (m_driver == BaseMysqlConfig::DRIVER_MYSQL);
+    QString rowPlaceholder = "(";
+    for (int i = 0; i < columns.size(); ++i) {
+        rowPlaceholder += (i == 0) ? "?" : ",?";
+    }
+    rowPlaceholder += ")";
+
+    QString verb = (upsert && !mysql) ? "INSERT OR REPLACE" : "INSERT";
+    QString sql = QString("%1 INTO %2 (%3) VALUES ").arg(verb).arg(tableName).arg(columns.join(","));
+    sql.reserve(sql.size() + count * (rowPlaceholder.size() + 1));
+    for (int i = 0; i < count; ++i) {
+        if (i > 0) sql += ",";
+        sql += rowPlaceholder;
+    }
+    if (upsert && mysql) {
+        QStringList assignments;
+        for (const QString& column : columns) {
+            assignments << QString("%1=VALUES(%1)").arg(column);
+        }
+        sql += " ON DUPLICATE KEY UPDATE " + assignments.join(",");
+    }
+    return sql;
+}
+
+void SqlService::finishBatch(BatchResult &result, qint64 elapsedMs, const QString &tag)
+{
+    result.elapsedMs = elapsedMs;
+    result.rowsPerSec = elapsedMs > 0 ? result.affectedRows * 1000.0 / elapsedMs : result.affectedRows;
+    if (result.success) {
+        LOG_INFOF("%1完成：%2行，%3个事务，耗时%4ms，%5行/秒",
+                  tag, result.totalRows, result.chunkCount, elapsedMs, qRound64(result.rowsPerSec));
+    } else {
+        LOG_ERRORF("%1失败：已提交%2/%3行，%4", tag, result.affectedRows, result.totalRows, result.errorMsg);
+    }
+}
+
+SqlService::BatchResult SqlService::BatchInsert(const QString &tableName, const QStringList &columns,
+                                                const QList<QVariantList> &rows, int chunkSize)
+{
+    return batchInsert(tableName, columns, rows, chunkSize, false);
+}
+
+SqlService::BatchResult SqlService::BatchUpsert(const QString &tableName, const QStringList &columns,
+                                                const QList<QVariantList> &rows, int chunkSize)
+{
+    return batchInsert(tableName, columns, rows, chunkSize, true);
+}
+
+SqlService::BatchResult SqlService::batchInsert(const QString &tableName, const QStringList &columns,
+                                                const QList<QVariantList> &rows, int chunkSize, bool upsert)
+{
+    BatchResult result;
+    result.totalRows = rows.size();
+    if (tableName.isEmpty() || columns.isEmpty()) {
+        result.errorMsg = "批量插入参数无效：表名或字段列表为空";
+        return result;
+    }
+    if (rows.isEmpty()) {
+        result.success = true;
+        return result;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    std::unique_lock<QMutex> locker(m_mutex, std::defer_lock);
+    if (!lockService(locker, -1, &result.errorMsg)) return result;
+    QSqlDatabase db = database();
+    if (!m_isConnected || !db.isOpen()) {
+        result.errorMsg = "数据库未连接";
+        return result;
+    }
+
+    // 每块行数受占位符上限约束
+    const int colCount = columns.size();
+    const int maxPlaceholders = (m_driver == BaseMysqlConfig::DRIVER_MYSQL) ? MYSQL_MAX_PLACEHOLDERS : SQLITE_MAX_PLACEHOLDERS;
+    const int rowsPerChunk = qBound(1, chunkSize, qMax(1, maxPlaceholders / colCount));
+
+    // 满块语句只准备一次，后续分块复用
+    QSqlQuery fullChunkQuery(db);
+    bool fullChunkPrepared = false;
+
+    for (int start = 0; start < rows.size(); start += rowsPerChunk) {
+        const int count = qMin(rowsPerChunk, rows.size() - start);
+        QSqlQuery partialQuery(db);
+        QSqlQuery* query = &fullChunkQuery;
+        if (count == rowsPerChunk) {
+            if (!fullChunkPrepared) {
+                QString sql = buildMultiRowInsertSql(tableName, columns, count, upsert);
+                if (!fullChunkQuery.prepare(sql)) {
+                    result.errorMsg = QString("SQL准备失败：%1（表：%2）").arg(fullChunkQuery.lastError().text()).arg(tableName);
+                    break;
+                }
+                fullChunkPrepared = true;
+            }
+        } else {
+            query = &partialQuery;
+            if (!partialQuery.prepare(buildMultiRowInsertSql(tableName, columns, count, upsert))) {
+                result.errorMsg = QString("SQL准备失败：%1（表：%2）").arg(partialQuery.lastError().text()).arg(tableName);
+                break;
+            }
+        }
+
+        // 按行依次绑定（占位符顺序与行列顺序一致）
+        int bindIndex = 0;
+        bool rowValid = true;
+        for (int r = start; r < start + count; ++r) {
+            const QVariantList& row = rows[r];
+            if (row.size() != colCount) {
+                result.errorMsg = QString("第%1行字段数%2与列数%3不一致").arg(r).arg(row.size()).arg(colCount);
+                rowValid = false;
+                break;
+            }
+            for (const QVariant& value : row) {
+                query->bindValue(bindIndex++, value);
+            }
+        }
+        if (!rowValid) break;
+
+        if (!db.transaction()) {
+            result.errorMsg = QString("开启事务失败：%1").arg(db.lastError().text());
+            break;
+        }
+        QElapsedTimer execTimer;
+        execTimer.start();
+        bool execOk = query->exec();
+        SqlStats::Sample sample;
+        sample.execUs = execTimer.nsecsElapsed() / 1000;
+        sample.rows = execOk ? count : 0;
+        sample.success = execOk;
+        m_sqlStats.record(query->lastQuery(), sample);
+        if (!execOk) {
+            result.errorMsg = QString("批量插入执行失败：%1（表：%2，起始行：%3）")
+                    .arg(query->lastError().text()).arg(tableName).arg(start);
+            db.rollback();
+            break;
+        }
+        if (!db.commit()) {
+            result.errorMsg = QString("提交事务失败：%1").arg(db.lastError().text());
+            db.rollback();
+            break;
+        }
+        result.affectedRows += count;
+        ++result.chunkCount;
+    }
+
+    m_lastWriteTimer.start();
+    m_queryCache.invalidateTables(QSet<QString>() << tableName.toLower());
+    result.success = result.errorMsg.isEmpty();
+    locker.unlock();
+    finishBatch(result, timer.elapsed(), QString(upsert ? "批量写入[%1]" : "批量插入[%1]").arg(tableName));
+    return result;
+}
+
+SqlService::BatchResult SqlService::BatchExec(const QString &sql, const QList<QVariantList> &rows, int chunkSize)
+{
+    BatchResult result;
+    result.totalRows = rows.size();
+    if (rows.isEmpty()) {
+        result.success = true;
+        return result;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    std::unique_lock<QMutex> locker(m_mutex, std::defer_lock);
+    if (!lockService(locker, -1, &result.errorMsg)) return result;
+    QSqlDatabase db = database();
+    if (!m_isConnected || !db.isOpen()) {
+        result.errorMsg = "数据库未连接";
+        return result;
+    }
+
+    QSqlQuery query(db);
+    if (!query.prepare(sql)) {
+        result.errorMsg = QString("SQL准备失败：%1（SQL：%2）").arg(query.lastError().text()).arg(sql);
+        return result;
+    }
+
+    const int paramCount = rows.first().size();
+    const int rowsPerChunk = qMax(1, chunkSize);
+    for (int start = 0; start < rows.size(); start += rowsPerChunk) {
+        const int count = qMin(rowsPerChunk, rows.size() - start);
+        // execBatch按列绑定：把分块内的行转置成每个占位符一列
+        QList<QVariantList> columnValues;
+        for (int c = 0; c < paramCount; ++c) {
+            columnValues.append(QVariantList());
+            columnValues.last().reserve(count);
+        }
+        bool rowValid = true;
+        for (int r = start; r < start + count; ++r) {
+            const QVariantList& row = rows[r];
+            if (row.size() != paramCount) {
+                result.errorMsg = QString("第%1行参数个数%2与占位符数%3不一致").arg(r).arg(row.size()).arg(paramCount);
+                rowValid = false;
+                break;
+            }
+            for (int c = 0; c < paramCount; ++c) {
+                columnValues[c].append(row[c]);
+            }
+        }
+        if (!rowValid) break;
+        for (int c = 0; c < paramCount; ++c) {
+            query.bindValue(c, columnValues[c]);
+        }
+
+        if (!db.transaction()) {
+            result.errorMsg = QString("开启事务失败：%1").arg(db.lastError().text());
+            break;
+        }
+        QElapsedTimer execTimer;
+        execTimer.start();
+        bool execOk = query.execBatch();
+        SqlStats::Sample sample;
+        sample.execUs = execTimer.nsecsElapsed() / 1000;
+        sample.rows = execOk ? count : 0;
+        sample.success = execOk;
+        m_sqlStats.record(sql, sample);
+        if (!execOk) {
+            result.errorMsg = QString("批量执行失败：%1（SQL：%2，起始行：%3）")
+                    .arg(query.lastError().text()).arg(sql).arg(start);
+            db.rollback();
+            break;
+        }
+        if (!db.commit()) {
+            result.errorMsg = QString("提交事务失败：%1").arg(db.lastError().text());
+            db.rollback();
+            break;
+        }
+        result.affectedRows += count;
+        ++result.chunkCount;
+    }
+
+    invalidateCacheForWrite(sql);
+    result.success = result.errorMsg.isEmpty();
+    locker.unlock();
+    finishBatch(result, timer.elapsed(), "批量执行");
     return result;
 }
+
+SqlService::TableSchema SqlService::getTableSchema(const QString &tableName, bool forceRefresh)
+{
+    QString key = tableName.trimmed().toLower();
+    if (key.isEmpty()) return TableSchema();
+    if (!forceRefresh) {
+        QMutexLocker locker(&m_schemaMutex);
+        auto it = m_schemaCache.constFind(key);
+        if (it != m_schemaCache.constEnd()) {
+            return it.value();
+        }
+    }
+
+    // 未命中：查询表结构（不持有缓存锁，避免阻塞其它表的读取）
+    const bool mysql = isMySql();
+    QueryResult descResult = GetData(mysql ? QString("DESC %1").arg(tableName)
+                                           : QString("PRAGMA table_info(%1)").arg(tableName));
+    if (!descResult.success) {
+        LOG_WARN(QString("加载表结构失败：%1").arg(descResult.errorMsg));
+        return TableSchema();
+    }
+    TableSchema schema;
+    for (const QVariantMap& row : descResult.data) {
+        QString field = row.value(mysql ? "Field" : "name").toString();
+        schema.columns.append(field);
+        schema.types.append(row.value(mysql ? "Type" : "type").toString());
+        bool primary = mysql ? row.value("Key").toString() == "PRI" : row.value("pk").toInt() > 0;
+        if (schema.primaryKey.isEmpty() && primary) {
+            schema.primaryKey = field;
+        }
+    }
+
+    QMutexLocker locker(&m_schemaMutex);
+    if (schema.isValid()) {
+        m_schemaCache.insert(key, schema);
+    }
+    return schema;
+}
+
+void SqlService::invalidateSchemaCache(const QString &tableName)
+{
+    QMutexLocker locker(&m_schemaMutex);
+    if (tableName.isEmpty()) {
+        m_schemaCache.clear();
+    } else {
+        m_schemaCache.remove(tableName.trimmed().toLower());
+    }
+}
+
+// 事务整体失败：所有语句均视为失败
+static QList<SqlService::QueryResult> failedResults(int count, const QString &error)
+{
+    QList<SqlService::QueryResult> results;
+    for (int i = 0; i < count; ++i) {
+        SqlService::QueryResult result;
+        result.success = false;
+        result.errorMsg = error;
+        results.append(result);
+    }
+    return results;
+}
+
+QList<SqlService::QueryResult> SqlService::ExecTransaction(const QList<SqlStatement> &statements, QString *errorMsg)
+{
+    QList<QueryResult> results;
+    QString error;
+    std::unique_lock<QMutex> locker(m_mutex, std::defer_lock);
+    if (!lockService(locker, -1, &error)) {
+        // 等锁超时，error为超时信息
+        if (errorMsg) *errorMsg = error;
+        return failedResults(statements.size(), error);
+    }
+    QSqlDatabase db = database();
+    if (!m_isConnected || !db.isOpen()) {
+        error = "数据库未连接";
+    } else if (!db.transaction()) {
+        error = QString("开启事务失败：%1").arg(db.lastError().text());
+    } else {
+        // 逐条执行，单条失败只记录该条结果，不影响其它语句提交
+        for (const SqlStatement& statement : statements) {
+            QueryResult result;
+            result.success = false;
+            SqlStats::Sample sample;
+            QElapsedTimer timer;
+            timer.start();
+            QSqlQuery query(db);
+            if (!query.prepare(statement.sql)) {
+                result.errorMsg = QString("SQL准备失败：%1（SQL：%2）").arg(query.lastError().text()).arg(statement.sql);
+            } else {
+                for (int i = 0; i < statement.params.size(); ++i) {
+                    query.bindValue(i, statement.params[i]);
+                }
+                sample.prepareUs = timer.nsecsElapsed() / 1000;
+                timer.restart();
+                bool ok = query.exec();
+                sample.execUs = timer.nsecsElapsed() / 1000;
+                sample.rows = ok ? query.numRowsAffected() : 0;
+                if (ok) {
+                    result.success = true;
+                    result.affectedRows = query.numRowsAffected();
+                } else {
+                    result.errorMsg = QString("NonQuery执行失败：%1（SQL：%2）").arg(query.lastError().text()).arg(statement.sql);
+                }
+            }
+            sample.success = result.success;
+            m_sqlStats.record(statement.sql, sample);
+            results.append(result);
+        }
+        if (!db.commit()) {
+            error = QString("提交事务失败：%1").arg(db.lastError().text());
+            db.rollback();
+        }
+        for (const SqlStatement& statement : statements) {
+            invalidateCacheForWrite(statement.sql);
+        }
+    }
+
+    if (!error.isEmpty()) {
+        results = failedResults(statements.size(), error);
+    }
+    if (errorMsg) *errorMsg = error;
+    return results;
+}
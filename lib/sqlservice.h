@@ -7,7 +7,57 @@
 #include<QSqlQuery>
 #include<QSqlRecord>
 #include<QList>
+#include<QStringList>
+#include<QMap>
+#include<QSet>
+#include<QThread>
+#include<QThreadStorage>
+#include<QTimer>
+#include<QElapsedTimer>
+#include<QHash>
+#include<QMutex>
+#include<QAtomicInt>
+#include<QSharedPointer>
+#include<atomic>
+#include<mutex>
 #include"iconfig.h"
+#include"querycache.h"
+#include"sqlstats.h"
+
+///
+/// \brief 查询取消令牌
+/// 可在任意线程调用cancel()且不等待：正在执行的MySQL语句由后台线程经旁路连接KILL QUERY终止，
+/// 已开始读取的结果集停止读取；取消后再用此令牌发起的查询直接返回失败
+///
+class SqlCancelToken : public QEnableSharedFromThis<SqlCancelToken>
+{
+public:
+    void cancel();
+    bool isCancelled() const { return m_cancelled.loadAcquire() != 0; }
+
+private:
+    friend class SqlService;
+    // 执行中语句所在的服务器连接
+    struct Target {
+        QString host;
+        int port = 3306;
+        QString user;
+        QString password;
+        qint64 connectionId = 0;  // CONNECTION_ID()
+    };
+    // 执行前登记（已取消时返回false），执行结束后注销；KILL进行中时detach等待其完成，避免误杀同连接的下一条语句
+    bool attach(const Target& target);
+    void detach();
+    // 经旁路连接发送KILL QUERY（持有m_mutex，语句已结束时跳过）
+    void killQuery();
+
+    QAtomicInt m_cancelled;
+    QMutex m_mutex;
+    Target m_target;
+    bool m_attached = false;
+};
+typedef QSharedPointer<SqlCancelToken> SqlCancelTokenPtr;
+
 class SqlService : public QObject
 {
     Q_OBJECT
@@ -24,13 +74,33 @@ private:
 public:
     // 1. 仅设置/更新数据库配置
     void setConfig(const BaseMysqlConfig& config);
+    // 运行中更新配置（config.ini热加载）：连接参数变化且处于连接状态时按新配置重连，返回是否重连
+    bool applyConfig(const BaseMysqlConfig& config);
     // 2. 根据当前配置建立数据库连接
     bool connectDb();
+    // 不阻塞调用线程的连接（在服务所在线程调用）：MySQL先由后台线程探测服务器可用，再打开连接；
+    // 结果通过connectionStateChanged通知，失败时按退避自动重连。SQLite在本地打开，直接连接
+    void connectDbAsync();
     // 3. 主动断开数据库连接
     void disconnectDb();
     // 4. 判断是否已连接
     bool isAvailable();
+    // 最近一次错误信息
+    QString lastError() const;
+    // 只读副本是否可用（未配置或已断开时读操作走主库）
+    bool isReplicaAvailable();
+    // 当前驱动（BaseMysqlConfig::DRIVER_*）
+    QString driver() const;
+    bool isMySql() const;
+    // SQL方言：日期时间格式化为yyyy-MM-dd HH:mm:ss的表达式；LIKE转义子句（反斜杠转义）
+    QString dateTimeExpr(const QString& column) const;
+    QString likeEscapeClause() const;
 
+signals:
+    // 连接状态变化（含断线检测与自动重连），总在服务所在线程发出
+    void connectionStateChanged(bool connected);
+
+public:
     struct QueryResult {
         bool success;          // 是否成功
         QList<QVariantMap> data; // 查询结果（查数据用）
@@ -41,8 +111,145 @@ public:
 
     QueryResult NonQuery(const QString& sql); // 增/删/改
     QueryResult GetData(const QString& sql);  // 查表格数据
+    QueryResult GetData(const QString& sql, const QList<QVariant>& params); // 查表格数据（参数绑定）
+    // 单次调用选项
+    struct QueryOptions {
+        int timeoutMs = -1;        // 执行超时（<0使用配置QueryTimeoutMs，0不限制）
+        int lockWaitMs = -1;       // 等待连接空闲（<0使用配置LockWaitMs，0一直等待）
+        SqlCancelTokenPtr cancel;  // 取消令牌（可为空）
+    };
+    QueryResult GetData(const QString& sql, const QList<QVariant>& params, const QueryOptions& options);
+    // 带结果缓存的查询：命中且未过期时直接返回，本服务写入相关表后自动失效（ttlMs<=0使用默认TTL）
+    QueryResult GetDataCached(const QString& sql, const QList<QVariant>& params = QList<QVariant>(), int ttlMs = 0);
+    // 增量拉取游标：上次读到的最后一行(变更时间, 主键)
+    struct DeltaCursor {
+        QVariant changeTime;
+        qint64 key = 0;
+        bool isStart() const { return !changeTime.isValid(); }
+    };
+    // 增量拉取：在selectSql（可带JOIN，不含WHERE/ORDER BY）后追加水位条件，按(changeExpr, keyExpr)升序取最多limit行；
+    // selectSql需选出changeExpr AS delta_time、keyExpr AS delta_key，读取后从结果中移除，成功时cursor推进到最后一行；结果不缓存
+    QueryResult GetDelta(const QString& selectSql, const QString& changeExpr, const QString& keyExpr,
+                         DeltaCursor& cursor, int limit = 1000, const QueryOptions& options = QueryOptions());
+    // 查询结果缓存（可调整TTL/内存上限或手动清空）
+    QueryCache& queryCache() { return m_queryCache; }
+    // SQL执行耗时统计（按指纹聚合，可查询或导出）
+    SqlStats& sqlStats() { return m_sqlStats; }
+
+    // 批量写入结果（含吞吐统计）
+    struct BatchResult {
+        bool success = false;    // 是否全部成功
+        QString errorMsg;        // 错误信息（首个失败分块）
+        int totalRows = 0;       // 提交的总行数
+        int affectedRows = 0;    // 已提交的受影响行数
+        int chunkCount = 0;      // 已提交的分块（事务）数
+        qint64 elapsedMs = 0;    // 总耗时（毫秒）
+        double rowsPerSec = 0.0; // 吞吐量（行/秒）
+    };
+    // 批量插入：按chunkSize分块，每块拼成一条多行INSERT…VALUES(…),(…)并包在一个事务中
+    BatchResult BatchInsert(const QString& tableName, const QStringList& columns,
+                            const QList<QVariantList>& rows, int chunkSize = 500);
+    // 批量写入或覆盖：主键/唯一键冲突时以新值覆盖（MySQL ON DUPLICATE KEY UPDATE，SQLite INSERT OR REPLACE），可重复执行
+    BatchResult BatchUpsert(const QString& tableName, const QStringList& columns,
+                            const QList<QVariantList>& rows, int chunkSize = 500);
+    // 批量执行同一条带?占位符的语句（UPDATE/DELETE等），每块execBatch后按事务提交
+    BatchResult BatchExec(const QString& sql, const QList<QVariantList>& rows, int chunkSize = 500);
+
+    // 事务内执行的单条语句
+    struct SqlStatement {
+        QString sql;          // 带?占位符的SQL
+        QVariantList params;  // 绑定参数
+    };
+    // 在一个事务中依次执行多条语句，返回与statements一一对应的结果；
+    // 开启/提交事务失败时全部视为失败，errorMsg返回事务级错误
+    QList<QueryResult> ExecTransaction(const QList<SqlStatement>& statements, QString* errorMsg = nullptr);
+
+    // 表结构元数据（按DESC顺序）
+    struct TableSchema {
+        QStringList columns;  // 字段名
+        QStringList types;    // 字段类型（与columns一一对应）
+        QString primaryKey;   // 主键字段（无主键为空）
+        bool isValid() const { return !columns.isEmpty(); }
+        QString columnAt(int col) const { return (col >= 0 && col < columns.size()) ? columns.at(col) : QString(); }
+    };
+    // 获取表结构：首次访问时查询并缓存，forceRefresh强制重新加载
+    TableSchema getTableSchema(const QString& tableName, bool forceRefresh = false);
+    // 清除表结构缓存（tableName为空时清除全部），重连时自动调用
+    void invalidateSchemaCache(const QString& tableName = QString());
 
 private:
+    // 连接路由：写操作与事务走主库，GetData优先走只读副本
+    enum class Route { Primary, Replica };
+    // 按当前配置打开主连接，withReplica时同时打开只读副本（调用方需持有m_mutex）
+    bool openLocked(bool withReplica = true);
+    // 驱动变更时按原连接名重建主/副本连接（调用方需持有m_mutex）
+    void ensureDriverLocked();
+    // SQLite库名（文件路径或共享内存库URI）
+    QString sqliteDatabaseName() const;
+    // 打开只读副本连接，失败时读操作回落主库（调用方需持有m_mutex）
+    bool openReplicaLocked();
+    // 标记只读副本不可用（调用方需持有m_mutex）
+    void markReplicaDownLocked(const QString& reason);
+    // 是否为连接断开类错误
+    static bool isConnectionLost(const QSqlError& error);
+    // 处理断线错误：tryReopen时尝试就地重开并返回是否恢复，否则标记断开并启动自动重连（调用方需持有m_mutex）
+    bool handleConnectionLostLocked(QSqlDatabase& db, const QSqlError& error, bool tryReopen);
+    // 通知连接状态变化并调整探活/重连定时器（线程安全，排队执行）
+    void notifyStateChanged(bool connected);
+    void onPingTimeout();
+    void onReconnectTimeout();
+    // 建立连接：withReplica为false时不打开只读副本（已探测不可达，交给探活恢复）
+    bool openConnection(bool withReplica);
+    // 自动重连：连接被占用时稍后再试
+    void reconnect(bool withReplica);
+    // 重连失败：加倍退避间隔后再试
+    void scheduleReconnect(const QString& error);
+    // 后台探测的目的与结果
+    enum class Probe { Connect, Reconnect, Ping };
+    struct ProbeResult {
+        bool reachable = false;         // 主库可用
+        bool replicaReachable = false;  // 只读副本可用（未配置为false）
+        QString error;
+        QString replicaError;
+    };
+    // 在后台线程用临时连接探测主库与只读副本，结果排队回服务线程交给onProbeFinished；
+    // 取不到配置（连接被占用）时返回false
+    bool startProbe(Probe purpose);
+    void onProbeFinished(Probe purpose, const ProbeResult& result);
+    // 查询实现：prepared为true时按params绑定
+    QueryResult execRead(const QString& sql, const QList<QVariant>& params, bool prepared,
+                         const QueryOptions& options = QueryOptions());
+    // 在限定时间内获取m_mutex交给locker（waitMs<0使用配置值，0一直等待），超时返回false并写入errorMsg
+    bool lockService(std::unique_lock<QMutex>& locker, int waitMs, QString* errorMsg);
+    // MySQL连接选项（连接超时+读写超时）
+    QString mysqlConnectOptions() const;
+    // 连接在服务器端的线程号，按连接名缓存，重开后失效（调用方需持有m_mutex）
+    qint64 connectionIdLocked(QSqlDatabase& db);
+    // 获取当前线程可用的连接（调用方需持有m_mutex）
+    QSqlDatabase database(Route route = Route::Primary);
+    // 作废工作线程克隆的连接：各线程下次使用时在本线程内关闭并按新配置重建（调用方需持有m_mutex）
+    void removeThreadConnections();
+    // 一个工作线程克隆的连接（主库/只读副本）：线程结束时由QThreadStorage在该线程内关闭并移除
+    struct ThreadConnections {
+        SqlService* owner = nullptr;
+        int generation = 0;   // 克隆时的连接代号，与m_connectionGeneration不同时作废
+        QString names[2];     // 按Route下标
+        ~ThreadConnections();
+        // 关闭并移除（在所属线程调用，调用方需持有owner->m_mutex）
+        void removeLocked();
+    };
+    // 写语句执行后淘汰相关表的缓存（无法识别表名时清空全部）
+    void invalidateCacheForWrite(const QString& sql);
+    // 读取查询结果集到result.data，返回估算字节数；cancel被取消时提前停止
+    static qint64 fetchRows(QSqlQuery& query, QueryResult& result, const SqlCancelToken* cancel = nullptr);
+    // BatchInsert/BatchUpsert实现
+    BatchResult batchInsert(const QString& tableName, const QStringList& columns,
+                            const QList<QVariantList>& rows, int chunkSize, bool upsert);
+    // 生成count行的多行INSERT语句（占位符形式，upsert时按当前驱动生成覆盖写法；调用方需持有m_mutex）
+    QString buildMultiRowInsertSql(const QString& tableName, const QStringList& columns, int count, bool upsert) const;
+    // 统计耗时并输出吞吐日志
+    static void finishBatch(BatchResult& result, qint64 elapsedMs, const QString& tag);
+
     QString getUniqueConnName() const {
         QString dbName = m_dbName.isEmpty() ? "DEFAULT_DB" : m_dbName;
         return QString("SQL_CONN_%1_%2").arg(dbName).arg((quint64)this);
@@ -50,14 +257,36 @@ private:
 private:
     QString m_dbName;          // 数据库实例名
     QSqlDatabase m_db;        // 数据库连接
-    bool m_isConnected;        // 连接状态
+    QSqlDatabase m_readDb;    // 只读副本连接
+    bool m_replicaAvailable = false; // 只读副本可用
+    QElapsedTimer m_lastWriteTimer;  // 距本服务上次写入的时间（写后短时间内读主库，避免副本延迟）
+    std::atomic<bool> m_isConnected;           // 连接状态（无锁读取，界面查询状态不被执行中的语句阻塞）
+    std::atomic<bool> m_wantConnected{false};  // 期望保持连接（主动断开后不再自动重连）
+    QTimer* m_pingTimer = nullptr;      // 探活定时器
+    QTimer* m_reconnectTimer = nullptr; // 重连定时器
+    int m_reconnectDelayMs = 1000;      // 当前重连退避间隔
+    int m_probeCount = 0;               // 进行中的后台探测数（只在服务线程访问）
     mutable QMutex m_mutex;    // 线程安全锁
     QString m_lastError;       // 错误信息
+    QThreadStorage<ThreadConnections*> m_threadConnections; // 各工作线程克隆的连接
+    int m_connectionGeneration = 0;           // 重连/断开时递增，作废已克隆的连接
+    QHash<QString, qint64> m_connectionIds;   // 连接名→服务器线程号（KILL QUERY用）
+    QueryCache m_queryCache;                  // 查询结果缓存
+    SqlStats m_sqlStats;                      // 执行耗时统计
+    QMap<QString, TableSchema> m_schemaCache; // 表结构缓存（表名→结构）
+    mutable QMutex m_schemaMutex;             // 表结构缓存锁
     // 数据库配置项（支持动态更新）
     QString m_host = "127.0.0.1";
     int m_port = 3306;
     QString m_user = "root";
     QString m_password = "123456"; // 若不同库密码不同，
+    QString m_readHost;            // 只读副本（为空表示不启用）
+    int m_readPort = 3306;
+    QString m_driver = BaseMysqlConfig::DRIVER_MYSQL; // 数据库驱动（写入时同时持有m_mutex与m_driverMutex）
+    mutable QMutex m_driverMutex;                     // 只读取驱动时使用，不等待执行中的语句
+    int m_queryTimeoutMs = 30000;  // 默认执行超时
+    QAtomicInt m_lockWaitMs{10000}; // 默认等锁时间
+    int m_readTimeoutSec = 60;     // MySQL驱动读写超时
 
 
 };
@@ -0,0 +1,184 @@
+﻿#include "sqlstats.h"
+#include "querycache.h"
+#include "ilogger.h"
+#include <QRegularExpression>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTextStream>
+#include <QDateTime>
+#include <cmath>
+#include <algorithm>
+
+// 指纹缓存上限（动态拼接的SQL过多时整体清空）
+static const int MAX_FINGERPRINT_CACHE = 4096;
+
+// 微秒换算为毫秒并保留1位小数（模板日志的参数在后台线程按最短形式输出）
+static double usToMs(qint64 us)
+{
+    return qRound64(us / 100.0) / 10.0;
+}
+
+SqlStats::SqlStats()
+{
+}
+
+void SqlStats::record(const QString &sql, const Sample &sample)
+{
+    const qint64 totalUs = sample.totalUs();
+    bool slow = false;
+    QString fp;
+    {
+        QMutexLocker locker(&m_mutex);
+        fp = cachedFingerprint(sql);
+        Entry& entry = m_entries[fp];
+        if (entry.buckets.isEmpty()) {
+            entry.buckets.fill(0, BUCKET_COUNT);
+        }
+        ++entry.count;
+        if (!sample.success) ++entry.errors;
+        entry.totalUs += totalUs;
+        entry.maxUs = qMax(entry.maxUs, totalUs);
+        entry.prepareUs += sample.prepareUs;
+        entry.execUs += sample.execUs;
+        entry.fetchUs += sample.fetchUs;
+        entry.rows += sample.rows;
+        entry.bytes += sample.bytes;
+        ++entry.buckets[bucketOf(totalUs)];
+        slow = m_slowThresholdUs > 0 && totalUs >= m_slowThresholdUs;
+        if (slow) ++entry.slowCount;
+    }
+    // 日志在锁外输出
+    if (slow) {
+        LOG_DEVICE_WARNF("SQL", "慢查询：%1ms（prepare %2ms / exec %3ms / fetch %4ms，%5行，%6字节）SQL：%7",
+                         usToMs(totalUs), usToMs(sample.prepareUs), usToMs(sample.execUs),
+                         usToMs(sample.fetchUs), sample.rows, sample.bytes, fp);
+    }
+}
+
+QList<SqlStats::Summary> SqlStats::summaries() const
+{
+    QList<Summary> list;
+    QList<qint64> totals;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+            const Entry& entry = it.value();
+            Summary summary;
+            summary.fingerprint = it.key();
+            summary.count = entry.count;
+            summary.errors = entry.errors;
+            summary.slowCount = entry.slowCount;
+            if (entry.count > 0) {
+                summary.avgMs = entry.totalUs / 1000.0 / entry.count;
+                summary.avgPrepareMs = entry.prepareUs / 1000.0 / entry.count;
+                summary.avgExecMs = entry.execUs / 1000.0 / entry.count;
+                summary.avgFetchMs = entry.fetchUs / 1000.0 / entry.count;
+            }
+            // 分桶上界估算，不超过实际最大值
+            summary.maxMs = entry.maxUs / 1000.0;
+            summary.p50Ms = qMin(summary.maxMs, percentileMs(entry.buckets, entry.count, 0.50));
+            summary.p95Ms = qMin(summary.maxMs, percentileMs(entry.buckets, entry.count, 0.95));
+            summary.p99Ms = qMin(summary.maxMs, percentileMs(entry.buckets, entry.count, 0.99));
+            summary.totalRows = entry.rows;
+            summary.totalBytes = entry.bytes;
+            list.append(summary);
+        }
+    }
+    std::sort(list.begin(), list.end(), [](const Summary& a, const Summary& b) {
+        return a.avgMs * a.count > b.avgMs * b.count;
+    });
+    return list;
+}
+
+bool SqlStats::dumpToFile(const QString &filePath) const
+{
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        LOG_WARN(QString("SQL统计导出失败：%1").arg(file.errorString()));
+        return false;
+    }
+    QTextStream out(&file);
+    out.setCodec("UTF-8");
+    out << "# SQL执行统计 " << QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss")
+        << "，慢查询阈值" << slowThresholdMs() << "ms\n";
+    out << "count\terrors\tslow\tavg_ms\tp50_ms\tp95_ms\tp99_ms\tmax_ms\tprepare_ms\texec_ms\tfetch_ms\trows\tbytes\tsql\n";
+    for (const Summary& s : summaries()) {
+        out << s.count << '\t' << s.errors << '\t' << s.slowCount << '\t'
+            << QString::number(s.avgMs, 'f', 2) << '\t'
+            << QString::number(s.p50Ms, 'f', 2) << '\t'
+            << QString::number(s.p95Ms, 'f', 2) << '\t'
+            << QString::number(s.p99Ms, 'f', 2) << '\t'
+            << QString::number(s.maxMs, 'f', 2) << '\t'
+            << QString::number(s.avgPrepareMs, 'f', 2) << '\t'
+            << QString::number(s.avgExecMs, 'f', 2) << '\t'
+            << QString::number(s.avgFetchMs, 'f', 2) << '\t'
+            << s.totalRows << '\t' << s.totalBytes << '\t' << s.fingerprint << '\n';
+    }
+    out.flush();
+    return true;
+}
+
+void SqlStats::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+}
+
+QString SqlStats::cachedFingerprint(const QString &sql)
+{
+    auto it = m_fingerprints.constFind(sql);
+    if (it != m_fingerprints.constEnd()) {
+        return it.value();
+    }
+    if (m_fingerprints.size() >= MAX_FINGERPRINT_CACHE) {
+        m_fingerprints.clear();
+    }
+    QString fp = fingerprint(sql);
+    m_fingerprints.insert(sql, fp);
+    return fp;
+}
+
+QString SqlStats::fingerprint(const QString &sql)
+{
+    static const QRegularExpression stringLiteral("'(?:[^'\\\\]|\\\\.|'')*'");
+    static const QRegularExpression numberLiteral("(?<![\\w$.])-?\\d+(?:\\.\\d+)?(?![\\w$])");
+    static const QRegularExpression inList("\\bIN\\s*\\((?:\\s*\\?\\s*,)*\\s*\\?\\s*\\)",
+                                           QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression valuesList("\\bVALUES\\s*(\\([^()]*\\))(?:\\s*,\\s*\\([^()]*\\))+",
+                                               QRegularExpression::CaseInsensitiveOption);
+
+    QString fp = QueryCache::normalizeSql(sql);
+    fp.replace(stringLiteral, "?");
+    fp.replace(numberLiteral, "?");
+    fp.replace(inList, "IN (?+)");
+    fp.replace(valuesList, "VALUES \\1,...");
+    return fp;
+}
+
+int SqlStats::bucketOf(qint64 us)
+{
+    if (us <= 1) return 0;
+    int bucket = int(std::log2(double(us)) * 4.0);
+    return qBound(0, bucket, BUCKET_COUNT - 1);
+}
+
+double SqlStats::bucketUpperMs(int bucket)
+{
+    return std::pow(2.0, (bucket + 1) / 4.0) / 1000.0;
+}
+
+double SqlStats::percentileMs(const QVector<quint32> &buckets, qint64 count, double ratio)
+{
+    if (count <= 0 || buckets.isEmpty()) return 0;
+    const qint64 target = qMax<qint64>(1, qint64(std::ceil(count * ratio)));
+    qint64 seen = 0;
+    for (int i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= target) {
+            return bucketUpperMs(i);
+        }
+    }
+    return bucketUpperMs(buckets.size() - 1);
+}
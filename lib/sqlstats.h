@@ -0,0 +1,94 @@
+﻿#ifndef SQLSTATS_H
+#define SQLSTATS_H
+
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QVector>
+#include <QMutex>
+
+///
+/// \brief SQL执行耗时统计
+/// 按SQL指纹（字面量替换为?）聚合prepare/exec/fetch各阶段耗时、行数、字节数，
+/// 用对数分桶直方图估算p50/p95/p99；超过慢查询阈值的语句写入日志
+///
+class SqlStats
+{
+public:
+    // 单次执行的采样（微秒）
+    struct Sample {
+        qint64 prepareUs = 0;
+        qint64 execUs = 0;
+        qint64 fetchUs = 0;
+        qint64 rows = 0;
+        qint64 bytes = 0;
+        bool success = true;
+        qint64 totalUs() const { return prepareUs + execUs + fetchUs; }
+    };
+
+    // 某个指纹的汇总
+    struct Summary {
+        QString fingerprint;
+        qint64 count = 0;
+        qint64 errors = 0;
+        qint64 slowCount = 0;
+        double avgMs = 0;
+        double p50Ms = 0;
+        double p95Ms = 0;
+        double p99Ms = 0;
+        double maxMs = 0;
+        double avgPrepareMs = 0;
+        double avgExecMs = 0;
+        double avgFetchMs = 0;
+        qint64 totalRows = 0;
+        qint64 totalBytes = 0;
+    };
+
+public:
+    SqlStats();
+
+    // 记录一次执行
+    void record(const QString& sql, const Sample& sample);
+    // 当前统计快照（按总耗时降序）
+    QList<Summary> summaries() const;
+    // 导出统计到文本文件
+    bool dumpToFile(const QString& filePath) const;
+    // 清空统计
+    void reset();
+
+    void setSlowThresholdMs(int ms) { QMutexLocker locker(&m_mutex); m_slowThresholdUs = qint64(qMax(0, ms)) * 1000; }
+    int slowThresholdMs() const { QMutexLocker locker(&m_mutex); return int(m_slowThresholdUs / 1000); }
+
+    // SQL指纹：规范化空白，字符串/数字字面量替换为?，IN列表与多行VALUES折叠
+    static QString fingerprint(const QString& sql);
+
+private:
+    static const int BUCKET_COUNT = 128;   // 每2倍耗时4个桶，覆盖1us~数小时
+    static int bucketOf(qint64 us);
+    static double bucketUpperMs(int bucket);
+    static double percentileMs(const QVector<quint32>& buckets, qint64 count, double ratio);
+
+    struct Entry {
+        qint64 count = 0;
+        qint64 errors = 0;
+        qint64 slowCount = 0;
+        qint64 totalUs = 0;
+        qint64 maxUs = 0;
+        qint64 prepareUs = 0;
+        qint64 execUs = 0;
+        qint64 fetchUs = 0;
+        qint64 rows = 0;
+        qint64 bytes = 0;
+        QVector<quint32> buckets;
+    };
+    // 原始SQL→指纹缓存，避免每次执行都跑正则
+    QString cachedFingerprint(const QString& sql);
+
+private:
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_entries;         // 指纹→统计
+    QHash<QString, QString> m_fingerprints;  // 原始SQL→指纹
+    qint64 m_slowThresholdUs = 500 * 1000;   // 默认500ms
+};
+
+#endif // SQLSTATS_H
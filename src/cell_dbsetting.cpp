@@ -26,11 +26,11 @@ void cell_Dbsetting::LoadConfigToUi()
 {
     try {
 
-      MysqlConfig& mysqlConfig= ConfigManager::Get().getConfig<MysqlConfig>();
-       ui->DatabaseEdit->setText(mysqlConfig.getDbName());
-       ui->PortEdit->setText(QString::number(mysqlConfig.getPort())); // int -> QString
-       ui->UserEdit->setText(mysqlConfig.getUsername());
-       ui->PasswordEdit->setText(mysqlConfig.getPassword());
+      std::shared_ptr<const MysqlConfig> mysqlConfig = ConfigManager::Get().snapshot<MysqlConfig>();
+       ui->DatabaseEdit->setText(mysqlConfig->getDbName());
+       ui->PortEdit->setText(QString::number(mysqlConfig->getPort())); // int -> QString
+       ui->UserEdit->setText(mysqlConfig->getUsername());
+       ui->PasswordEdit->setText(mysqlConfig->getPassword());
    }
     catch (const std::runtime_error& e)
     {
@@ -44,12 +44,18 @@ void cell_Dbsetting::LoadConfigToUi()
 void cell_Dbsetting::on_confirmBtn_clicked()
 {
     try {
-        MysqlConfig& mysqlConfig= ConfigManager::Get().getConfig<MysqlConfig>();
-        mysqlConfig.setDbName(ui->DatabaseEdit->text().trimmed());
-        mysqlConfig.setPort(ui->PortEdit->text().toInt()); // QString -> int
-        mysqlConfig.setUsername(ui->UserEdit->text().trimmed());
-        mysqlConfig.setPassword(ui->PasswordEdit->text().trimmed());
-        ConfigManager::Get().saveAllConfig();
+        ConfigManager::Get().update<MysqlConfig>([this](MysqlConfig& mysqlConfig) {
+            mysqlConfig.setDbName(ui->DatabaseEdit->text().trimmed());
+            mysqlConfig.setPort(ui->PortEdit->text().toInt()); // QString -> int
+            mysqlConfig.setUsername(ui->UserEdit->text().trimmed());
+            mysqlConfig.setPassword(ui->PasswordEdit->text().trimmed());
+        });
+        // 立即写入config.ini，确认写入成功后再提示
+        QString errorMsg;
+        if (!ConfigManager::Get().flush(&errorMsg)) {
+            QMessageBox::critical(this, "错误", QString("保存配置失败：%1\n修改已生效，稍后将自动重试写入").arg(errorMsg));
+            return;
+        }
         QMessageBox::information(this, "提示", "数据库配置保存成功！");
         this->close(); // 保存后关闭窗口
     } catch (const std::runtime_error& e) {
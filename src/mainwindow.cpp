@@ -11,6 +11,12 @@
 #include <windows.h>
 #include <tlhelp32.h>
 #include <QRegularExpression>
+#include <QAbstractItemView>
+#include <QScrollBar>
+#include <QLineEdit>
+#include <QSignalBlocker>
+#include <QPointer>
+#include "lib/measurementcsv.h"
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -26,6 +32,24 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    // 取消进行中的同步查询并等待线程结束，避免退出时仍在写本地缓存
+    if (m_productLoadThread) {
+        m_productLoadThread->wait();
+    }
+    if (m_productSyncThread) {
+        if (m_productSyncCancel) m_productSyncCancel->cancel();
+        m_productSyncThread->wait();
+    }
+    if (m_measurementImportThread) {
+        if (m_measurementImportCancel) m_measurementImportCancel->cancel();
+        m_measurementImportThread->wait();
+    }
+    // 停止报告队列：正在生成的报告在下一个检查点取消，排队中的丢弃
+    delete m_reportQueue;
+    m_reportQueue = nullptr;
+    // 导出本次运行的SQL耗时统计，便于对比回归
+    QString statsPath = QDir(QCoreApplication::applicationDirPath()).filePath("Log/sql_stats.txt");
+    SqlService::Get().sqlStats().dumpToFile(statsPath);
     delete ui;
 }
 void MainWindow::syncButtonStateWithDbStatus()
@@ -52,140 +76,369 @@ void MainWindow::InitCtrl()
     //设置数据库
     ui->dbIPBox->setEditable(true);
 
-    mysqlConfig=&ConfigManager::Get().getConfig<MysqlConfig>();
+    //工作令号：可输入前缀，服务器端过滤+滚动分页
+    ui->joborderCombox->setEditable(true);
+    ui->joborderCombox->setInsertPolicy(QComboBox::NoInsert);
+    m_jobOrderFilterTimer.setSingleShot(true);
+    m_jobOrderFilterTimer.setInterval(300);
+    connect(&m_jobOrderFilterTimer, &QTimer::timeout, this, &MainWindow::onJobOrderFilterTimeout);
+    connect(ui->joborderCombox->lineEdit(), &QLineEdit::textEdited, this, &MainWindow::onJobOrderTextEdited);
+    connect(ui->joborderCombox->view()->verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &MainWindow::onJobOrderListScrolled);
+
+    std::shared_ptr<const MysqlConfig> mysqlConfig = ConfigManager::Get().snapshot<MysqlConfig>();
     SqlService::Get().setConfig(*mysqlConfig);
+    //config.ini修改后热加载：只有数据库配置节变化时才更新连接
+    connect(&ConfigManager::Get(), &ConfigManager::mysqlConfigChanged, this,
+            [](std::shared_ptr<const MysqlConfig> config) {
+        SqlService::Get().applyConfig(*config);
+    });
+    connect(&ConfigManager::Get(), &ConfigManager::saveFailed, this, [](const QString &error) {
+        LOG_ERRORF("保存config.ini失败，稍后重试：%1", error);
+    });
     QList<QString>list=mysqlConfig->getPresetIps();
     ui->dbIPBox->addItems(list);
     syncButtonStateWithDbStatus();
+    //断线检测/自动重连后同步按钮状态
+    connect(&SqlService::Get(), &SqlService::connectionStateChanged, this, [this](bool connected) {
+        if (m_dbConnecting) {
+            m_dbConnecting = false;
+            if (connected) {
+                LOG_INFO("数据库连接成功");
+            } else {
+                LOG_ERROR(QString("数据库连接失败：%1").arg(SqlService::Get().lastError()));
+            }
+        }
+        syncButtonStateWithDbStatus();
+        if (connected) {
+            //连上（含断线恢复）后加载产品数据：有本地缓存时补齐离线期间新增的产品
+            QueryProuductData();
+            StartMeasurementImport();
+        }
+    });
 
-    //连接数据库
-    on_dbConnectBt_clicked();
-    //根据工作令号-查询产品数据
-    QueryProuductData();
+    //先显示本地缓存的产品数据，不等待数据库
+    LoadLocalProductCache();
+    //连接数据库延后到窗口显示之后，连上后在connectionStateChanged中查询产品数据
+    QTimer::singleShot(0, this, &MainWindow::on_dbConnectBt_clicked);
 
     //报告类型
     QString templatePath="word_template";
     LoadReportType(templatePath);
+    InitReportQueue();
+
+}
 
+void MainWindow::InitReportQueue()
+{
+    m_reportQueue = new ReportQueue(this);
+    connect(m_reportQueue, &ReportQueue::jobQueued, this, [this](int jobId, int pendingCount) {
+        LOG_INFOF("报告任务%1已加入队列（未完成%2个）", jobId, pendingCount);
+        UpdateReportStatus(QString());
+    });
+    connect(m_reportQueue, &ReportQueue::jobStarted, this, [this](int jobId, const QString &savePath) {
+        LOG_INFOF("开始生成报告任务%1：%2", jobId, savePath);
+        ui->reportProgressBar->setValue(0);
+        UpdateReportStatus(QString("任务%1 准备中").arg(jobId));
+    });
+    connect(m_reportQueue, &ReportQueue::jobProgress, this, [this](int jobId, int phase, const QString &text) {
+        ui->reportProgressBar->setValue(phase);
+        UpdateReportStatus(QString("任务%1 %2").arg(jobId).arg(text));
+    });
+    connect(m_reportQueue, &ReportQueue::jobFinished, this, [this](int jobId, bool success, const QString &message) {
+        if (success) {
+            LOG_INFOF("报告任务%1已生成：%2", jobId, message);
+        } else {
+            LOG_WARNF("报告任务%1未生成：%2", jobId, message);
+        }
+        ui->reportProgressBar->setValue(success ? DimReport::PhaseCount : 0);
+        UpdateReportStatus(QString("任务%1 %2").arg(jobId).arg(success ? "完成" : message));
+    });
+
+    // 任务日志与生成报告目录同级：恢复上次异常退出时未完成的报告
+    const QString journalPath = QDir(QCoreApplication::applicationDirPath()).filePath("report_jobs.jsonl");
+    const int resumed = m_reportQueue->openJournal(journalPath);
+    if (resumed > 0) {
+        LOG_INFO(QString("恢复上次未完成的报告任务%1个").arg(resumed));
+    }
+}
+
+void MainWindow::UpdateReportStatus(const QString &text)
+{
+    if (!text.isEmpty()) {
+        m_reportStatusText = text;
+    }
+    const int pendingCount = m_reportQueue->pendingCount();
+    QString status = m_reportStatusText;
+    if (pendingCount > 1) {
+        status += QString(" | 未完成%1个").arg(pendingCount);
+    }
+    ui->reportProgressBar->setFormat(status);
+    ui->cancelReportBt->setEnabled(m_reportQueue->runningJobId() != 0);
 }
 
 bool MainWindow::QueryProuductData()
+{
+    // 本地缓存加载中：加载完成后再同步或在线查询
+    if (m_localCacheLoading) {
+        return true;
+    }
+    // 有本地缓存：只在后台拉取水位之后的新记录
+    if (m_localCacheReady) {
+        if (!SqlService::Get().isAvailable()) {
+            LOG_WARN("数据库未连接，显示本地缓存的产品数据");
+            return !m_productCatalog.isEmpty();
+        }
+        StartProductDeltaSync();
+        return true;
+    }
+    // 刷新：清空已加载的完整记录，按当前输入前缀重新加载第一页
+    m_productCatalog.clear();
+    return LoadJobOrderPage(true);
+}
+
+void MainWindow::LoadLocalProductCache()
+{
+    // 读取与JSON解析在后台线程进行，窗口启动时不等待
+    QPointer<MainWindow> self(this);
+    QThread *thread = QThread::create([self]() {
+        ProductLocalCache::LoadResult result = ProductLocalCache::loadFromFile();
+        QMetaObject::invokeMethod(qApp, [self, result]() {
+            if (self) self->OnLocalProductCacheLoaded(result);
+        }, Qt::QueuedConnection);
+    });
+    m_productLoadThread = thread;
+    m_localCacheLoading = true;
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    thread->start();
+}
+
+void MainWindow::OnLocalProductCacheLoaded(const ProductLocalCache::LoadResult &result)
+{
+    m_localCacheLoading = false;
+    if (!result.opened) {
+        LOG_WARNF("本地产品缓存不可用，改为在线查询：%1", result.errorMsg);
+    } else {
+        if (!result.errorMsg.isEmpty()) {
+            LOG_WARNF("读取本地产品缓存失败：%1", result.errorMsg);
+        }
+        m_localCacheReady = true;
+        MergeProductRecords(result.records);
+        LOG_INFOF("已从本地缓存加载%1条产品记录，耗时%2ms", result.records.size(), result.elapsedMs);
+    }
+    // 加载期间已连上数据库：补做被推迟的同步/在线查询
+    if (SqlService::Get().isAvailable()) {
+        QueryProuductData();
+    }
+}
+
+void MainWindow::MergeProductRecords(const QList<QVariantMap> &records)
+{
+    // 按product_id覆盖（upsert），工作令号被修改时目录自动移除旧键
+    m_productCatalog.reserve(m_productCatalog.size() + records.size());
+    for (const QVariantMap &record : records)
+    {
+        m_productCatalog.upsert(record);
+    }
+    FillJobOrderComboFromCache(m_jobOrderPrefix);
+}
+
+void MainWindow::FillJobOrderComboFromCache(const QString &prefix)
+{
+    // 多取一个用于判断是否超出上限
+    QStringList jobOrderList = m_productCatalog.jobOrdersWithPrefix(prefix, MAX_COMBO_ITEMS + 1);
+    if (jobOrderList.size() > MAX_COMBO_ITEMS) {
+        jobOrderList.removeLast();
+        LOG_DEBUG(QString("匹配的工作令号超过%1个，请输入更长的前缀").arg(MAX_COMBO_ITEMS));
+    }
+    QSignalBlocker blocker(ui->joborderCombox);
+    QString editText = ui->joborderCombox->currentText();
+    ui->joborderCombox->clear();
+    ui->joborderCombox->addItems(jobOrderList);
+    if (!editText.isEmpty()) {
+        ui->joborderCombox->setEditText(editText);
+    }
+}
+
+void MainWindow::StartProductDeltaSync()
+{
+    if (m_productSyncThread) {
+        // 同步进行中：结束后再补一次
+        m_productSyncPending = true;
+        return;
+    }
+    if (!SqlService::Get().isAvailable()) return;
+
+    QPointer<MainWindow> self(this);
+    SqlCancelTokenPtr cancel(new SqlCancelToken);
+    m_productSyncCancel = cancel;
+    QThread *thread = QThread::create([self, cancel]() {
+        ProductLocalCache::SyncResult result = ProductLocalCache::syncFromServer(QString(), 1000, cancel);
+        QMetaObject::invokeMethod(qApp, [self, result]() {
+            if (self) self->OnProductDeltaSynced(result);
+        }, Qt::QueuedConnection);
+    });
+    m_productSyncThread = thread;
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    // 线程结束后才能开始下一次：先清除指针（deleteLater尚未执行），再补上同步期间收到的请求
+    connect(thread, &QThread::finished, this, [this, thread]() {
+        if (m_productSyncThread == thread) m_productSyncThread = nullptr;
+        if (m_productSyncPending) {
+            m_productSyncPending = false;
+            StartProductDeltaSync();
+        }
+    });
+    thread->start();
+}
+
+void MainWindow::OnProductDeltaSynced(const ProductLocalCache::SyncResult &result)
+{
+    if (!result.success) {
+        LOG_ERROR(QString("产品数据增量同步失败：%1").arg(result.errorMsg));
+    } else if (result.records.isEmpty()) {
+        LOG_INFO("产品数据已是最新");
+    } else {
+        MergeProductRecords(result.records);
+        LOG_INFOF("产品数据增量同步（新增/修改）%1条，耗时%2ms", result.records.size(), result.elapsedMs);
+    }
+}
+
+void MainWindow::StartMeasurementImport()
+{
+    // 已导入且未变化的文件会被跳过，每次连上数据库补导即可
+    if (m_measurementImportThread) return;
+    const QString csvDir = targetPath;
+    MeasurementImporter::Options options;
+    options.cancel = SqlCancelTokenPtr(new SqlCancelToken);
+    m_measurementImportCancel = options.cancel;
+    m_measurementImportThread = QThread::create([csvDir, options]() {
+        MeasurementImporter::Result result = MeasurementImporter::importDirectory(csvDir, options);
+        if (result.cancelled) {
+            LOG_INFOF("检测数据入库已取消（已导入%1个文件）", result.importedFiles);
+            return;
+        }
+        if (!result.errorMsg.isEmpty() && result.totalFiles == 0) {
+            LOG_WARN(QString("检测数据入库失败：%1").arg(result.errorMsg));
+            return;
+        }
+        LOG_INFOF("检测数据入库：共%1个文件，导入%2个（%3行），跳过%4个，失败%5个，耗时%6ms",
+                  result.totalFiles, result.importedFiles, result.rows,
+                  result.skippedFiles, result.failedFiles, result.elapsedMs);
+        for (const QString& failure : result.failures) {
+            LOG_WARNF("检测数据入库失败：%1", failure);
+        }
+    });
+    connect(m_measurementImportThread, &QThread::finished, m_measurementImportThread, &QObject::deleteLater);
+    m_measurementImportThread->start();
+}
+
+bool MainWindow::LoadJobOrderPage(bool reset)
 {
       // 1. 数据库连接检查
     if(!SqlService::Get().isAvailable())
     {
         LOG_ERROR("数据库未连接，无法查询工艺信息");
         ui->joborderCombox->clear();
-        m_jobOrderToRecordMap.clear(); // 清空类成员变量
+        m_productCatalog.clear(); // 清空类成员变量
         return false;
     }
-   //字段映射
-    const QMap<QString, QString> fieldToHeaderMap = {
-           {"product_id", "产品ID"},
-           {"product_name", "产品名称"},
-           {"job_order_no", "工作令号"},
-           {"material_grade", "材质"},
-           {"customer_po", "客户单号"},
-           {"part_no", "零件号"},
-           {"product_serial_no", "产品序列号"},
-           {"drawing_no", "图号"},
-           {"part_description", "零件描述"},
-           {"smelting_furnace_no", "冶炼炉号"},
-           {"heat_treatment_furnace_no", "热处理炉号"},
-           {"heat_treatment_state", "热处理状态"},
-           {"client_name", "委托单位"},
-           {"quantity", "产品数量"},
-           {"reviewer_result", "审核结果"},
-           {"tool_name", "测量工具名称"},
-           {"editor_name", "编制人员"},
-           {"editor_opinion", "编制人员意见"},
-           {"reviewer_name", "审核人员"},
-           {"reviewer_opinion", "审核人员意见"},
-           {"detection_standard_code", "检测标准号"},
-           {"acceptance_standard_code", "验收标准号"},
-           {"create_time", "年月日"}
-    };
-     // 2. 构造SQL并执行查询
-    const QString TableName="product_base_info";
-    // 查询产品基础表
-    QString productSql = QString(R"(
-               SELECT
-                   p.product_id,
-                   p.product_name,
-                   p.job_order_no,
-                   p.material_grade,
-                   p.customer_po,
-                   p.part_no,
-                   p.product_serial_no,
-                   p.drawing_no,
-                   p.part_description,
-                   p.smelting_furnace_no,
-                   p.heat_treatment_furnace_no,
-                   p.heat_treatment_state,
-                   p.client_name,
-                   p.quantity,
-                   p.reviewer_result,
-                   m.tool_name, -- 关联测量工具表
-                   m.tool_no,
-                   p.editor_name,
-                   p.editor_opinion,
-                   p.reviewer_name,
-                   p.reviewer_opinion,
-                   d.standard_code AS detection_standard_code, -- 关联检测标准表
-                   a.acceptance_code AS acceptance_standard_code, -- 关联验收标准表
-                   DATE_FORMAT(p.create_time, '%Y-%m-%d %H:%i:%s') AS create_time
-               FROM %1 p
-               LEFT JOIN measurement_tool m ON p.tool_id = m.tool_id
-               LEFT JOIN detection_standard d ON p.standard_id = d.standard_id
-               LEFT JOIN acceptance_standard a ON p.acceptance_id = a.acceptance_id
-               ORDER BY  p.create_time ASC
-           )").arg(TableName);
-       // 执行查询
-       SqlService::QueryResult productResult = SqlService::Get().GetData(productSql);
-       if (!productResult.success)
-       {
-           LOG_ERROR(QString("加载产品基础数据失败：%1").arg(productResult.errorMsg));
-           QMessageBox::critical(this, "错误", QString("加载数据失败：%1").arg(productResult.errorMsg));
-           return false;
-       }
-       int rowCount = productResult.data.size();
-       LOG_INFO(QString("产品基础信息查询到%1行记录").arg(rowCount));
-        // 3. 清空旧数据
-       ui->joborderCombox->clear();
-       m_jobOrderToRecordMap.clear();
-       if (rowCount == 0) {
-           LOG_INFO("产品表暂无数据");
-           return false;
-       }
-       // 5. 遍历QVariantMap类型的结果：
-       QStringList jobOrderList;
-       for (const QVariantMap &record : productResult.data)
-       {
-           QString jobOrderNo = record.value("job_order_no").toString().trimmed();
-           if (jobOrderNo.isEmpty()) {
-               continue;
-           }
-           jobOrderList.append(jobOrderNo);
-           m_jobOrderToRecordMap.insert(jobOrderNo, record);
-       }
-       ui->joborderCombox->addItems(jobOrderList);
-       return true;
+    if (reset) {
+        m_jobOrderCursor = ProductQuery::PageCursor();
+        m_jobOrderHasMore = false;
+    } else if (!m_jobOrderHasMore) {
+        return true;
+    }
+
+    // 2. 按前缀+键集游标查询一页工作令号
+    ProductQuery::JobOrderPage page = ProductQuery::fetchJobOrderPage(m_jobOrderPrefix, m_jobOrderCursor, JOB_ORDER_PAGE_SIZE);
+    if (!page.success)
+    {
+        LOG_ERROR(QString("加载产品基础数据失败：%1").arg(page.errorMsg));
+        QMessageBox::critical(this, "错误", QString("加载数据失败：%1").arg(page.errorMsg));
+        return false;
+    }
+    m_jobOrderCursor = page.next;
+    m_jobOrderHasMore = page.hasMore;
+    LOG_INFO(QString("产品基础信息查询到%1行记录%2").arg(page.jobOrders.size()).arg(page.hasMore ? "（还有更多）" : ""));
+
+    // 3. 更新下拉框（追加下一页时保留当前文本）
+    QSignalBlocker blocker(ui->joborderCombox);
+    QString editText = ui->joborderCombox->currentText();
+    if (reset) {
+        ui->joborderCombox->clear();
+    }
+    ui->joborderCombox->addItems(page.jobOrders);
+    if (!reset) {
+        ui->joborderCombox->setEditText(editText);
+    }
+    if (reset && page.jobOrders.isEmpty()) {
+        LOG_INFO("产品表暂无数据");
+        return false;
+    }
+    return true;
+}
+
+void MainWindow::onJobOrderTextEdited(const QString &text)
+{
+    Q_UNUSED(text)
+    // 输入停顿后再向服务器查询，避免每个按键一次查询
+    m_jobOrderFilterTimer.start();
+}
+
+void MainWindow::onJobOrderFilterTimeout()
+{
+    QString typedText = ui->joborderCombox->currentText();
+    m_jobOrderPrefix = typedText.trimmed();
+    if (m_localCacheReady) {
+        FillJobOrderComboFromCache(m_jobOrderPrefix);
+        return;
+    }
+    QueryProuductData();
+    // 保留用户输入，列表中只剩匹配前缀的工作令号
+    ui->joborderCombox->setEditText(typedText);
+}
+
+void MainWindow::onJobOrderListScrolled(int value)
+{
+    // 滚动到列表底部时加载下一页
+    QScrollBar* bar = ui->joborderCombox->view()->verticalScrollBar();
+    if (m_jobOrderHasMore && value >= bar->maximum()) {
+        LoadJobOrderPage(false);
+    }
+}
+
+ProductInfo MainWindow::productInfo(const QString &jobOrder)
+{
+    if (const ProductInfo* info = m_productCatalog.findByJobOrder(jobOrder)) {
+        return *info;
+    }
+    // 仅在选中时按需查询完整记录
+    QString errorMsg;
+    QVariantMap record = ProductQuery::fetchRecordByJobOrder(jobOrder, &errorMsg);
+    if (record.isEmpty()) {
+        LOG_ERROR(QString("查询工作令号%1的产品记录失败：%2").arg(jobOrder).arg(errorMsg.isEmpty() ? "无记录" : errorMsg));
+        return ProductInfo();
+    }
+    ProductInfo info = ProductInfo::fromRecord(record);
+    m_productCatalog.upsert(info);
+    return info;
 }
 
 void MainWindow::GetProductParams(DimReport::ProductParam *params)
 {
     if(params)
     {
-        QString currentJobOrder=ui->joborderCombox->currentText();
-
-        params->jobOrder = m_jobOrderToRecordMap[currentJobOrder].value("job_order_no").toString();
-        params->materialGrade =  m_jobOrderToRecordMap[currentJobOrder].value("material_grade").toString();
-        params->customer = m_jobOrderToRecordMap[currentJobOrder].value("customer_po").toString();
-        params->productSerialNo = m_jobOrderToRecordMap[currentJobOrder].value("product_serial_no").toString();
-        params->MeasurementTool = m_jobOrderToRecordMap[currentJobOrder].value("tool_name").toString();
-        params->MeasurementNo = m_jobOrderToRecordMap[currentJobOrder].value("tool_no").toString();
-        params->reviewName=m_jobOrderToRecordMap[currentJobOrder].value("reviewer_name").toString();
-        params->Inspector=m_jobOrderToRecordMap[currentJobOrder].value("editor_name").toString();
+        QString currentJobOrder=ui->joborderCombox->currentText().trimmed();
+        const ProductInfo info = productInfo(currentJobOrder);
+
+        params->jobOrder = info.jobOrderNo;
+        params->materialGrade = info.materialGrade;
+        params->customer = info.customerPo;
+        params->productSerialNo = info.productSerialNo;
+        params->MeasurementTool = info.toolName;
+        params->MeasurementNo = info.toolNo;
+        params->reviewName = info.reviewerName;
+        params->Inspector = info.editorName;
     }
     else
     {
@@ -259,72 +512,25 @@ QList<DimReport::InspectionParam> MainWindow::buildParamMapFromCsv()
     }
 
     QString csvFilePath = QDir(targetPath).filePath(csvFileName);
-    QFile csvFile(csvFilePath);
-    if (!csvFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QMessageBox::warning(nullptr, "错误", QString("无法打开CSV文件：%1").arg(csvFilePath));
-        return paramList;
-    }
-
-    QTextStream in(&csvFile);
-    QStringList csvLines;
-    while (!in.atEnd() && csvLines.size() < 2) {
-        QString line = in.readLine().trimmed();
-        if (!line.isEmpty()) {
-            csvLines.append(line);
+    QString errorMsg;
+    // 优先读取已入库的检测数据，文件未导入（或导入后被修改）时再解析CSV
+    if (SqlService::Get().isAvailable()) {
+        paramList = MeasurementImporter::loadParams(csvFilePath, &errorMsg);
+        if (!paramList.isEmpty()) {
+            qDebug() << QString("从检测数据库读取%1个检测参数").arg(paramList.size());
+            return paramList;
+        }
+        if (!errorMsg.isEmpty()) {
+            LOG_WARNF("读取已入库的检测数据失败，改为解析CSV：%1", errorMsg);
+            errorMsg.clear();
         }
     }
-    csvFile.close();
-
-    if (csvLines.size() < 2) {
-        QMessageBox::warning(nullptr, "错误", QString("CSV格式异常！仅读取到%1行，要求固定2行（表头+数据）").arg(csvLines.size()));
+    paramList = MeasurementCsv::parse(csvFilePath, &errorMsg);
+    if (!errorMsg.isEmpty()) {
+        QMessageBox::warning(nullptr, "错误", errorMsg);
         return paramList;
     }
 
-    QStringList headerColumns = csvLines[0].split(",");
-    QStringList dataColumns = csvLines[1].split(",");
-
-    QRegularExpression headerRegex("^([a-zA-Z]+)_(.*)$");
-    QMap<QString, QMap<QString, QString>> paramAttrMap; // 这一步暂时保留，用于组装参数属性
-
-    for (int colIndex = 0; colIndex < headerColumns.size(); ++colIndex)
-    {
-        QString header = headerColumns[colIndex].trimmed();
-        QString data = (colIndex < dataColumns.size()) ? dataColumns[colIndex].trimmed() : "";
-
-        QRegularExpressionMatch match = headerRegex.match(header);
-        if (!match.hasMatch()) continue;
-
-        QString attrType = match.captured(1);
-        QString paramName = match.captured(2);
-        paramAttrMap[paramName][attrType] = data;
-    }
-
-    auto convertToVariant = [](const QString& str) -> QVariant {
-        if (str.compare("N/A", Qt::CaseInsensitive) == 0) return QVariant("N/A");
-        bool isNumber;
-        double num = str.toDouble(&isNumber);
-        if (isNumber && qFuzzyCompare(num, 7777777.0)) return QVariant("无效值");
-        return str.isEmpty() ? QVariant("") : (isNumber ? QVariant(num) : QVariant(str));
-    };
-
-    // 遍历属性Map，组装成InspectionParam并加入QList
-    for (auto attrMapIt = paramAttrMap.begin(); attrMapIt != paramAttrMap.end(); ++attrMapIt)
-    {
-        QString paramName = attrMapIt.key();
-        QMap<QString, QString> attrMap = attrMapIt.value();
-
-        DimReport::InspectionParam param;
-        param.name = paramName;
-        param.defaultValue = convertToVariant(attrMap.value("DefaultValue", ""));
-        param.maxValue = convertToVariant(attrMap.value("Max", ""));
-        param.minValue = convertToVariant(attrMap.value("Min", ""));
-        param.actualValue = convertToVariant(attrMap.value("ActualValue", ""));
-        param.offset = convertToVariant(attrMap.value("Offset", ""));
-        param.overOffset = convertToVariant(attrMap.value("OverOffset", ""));
-
-        paramList.append(param); // 直接加入QList，无需Map存储
-    }
-
     qDebug() << QString("CSV解析成功！共提取%1个检测参数").arg(paramList.size());
     return paramList;
 }
@@ -335,19 +541,11 @@ QList<DimReport::InspectionParam> MainWindow::buildParamMapFromCsv()
 
 void MainWindow::on_dbConnectBt_clicked()
 {
-    bool connectSuccess = SqlService::Get().connectDb(); // 假设你有connectDb方法，返回连接结果
-
-    if (connectSuccess)
-    {
-        LOG_INFO("数据库连接成功");
-    }
-    else
-    {
-        LOG_ERROR("数据库连接失败");
-    }
-
-    // 关键：连接操作后，同步按钮状态（实现互斥）
-    syncButtonStateWithDbStatus();
+    // 后台探测服务器后再连接，界面不等待连接超时；结果在connectionStateChanged中输出并同步按钮状态
+    m_dbConnecting = true;
+    ui->dbConnectBt->setEnabled(false);
+    ui->dbConnectBt->setText("连接中");
+    SqlService::Get().connectDbAsync();
 }
 
 void MainWindow::on_dbdisConnectBt_clicked()
@@ -381,8 +579,8 @@ void MainWindow::on_dbsetBt_clicked()
 
 void MainWindow::on_generateReportBt_clicked()
 {
-    // 1. 创建尺寸报告实例
-   DimReport dimReport;
+    // 1. 准备报告任务（Word在后台队列中生成，界面可继续选择下一个零件）
+   ReportQueue::Job job;
    QString appDir = QCoreApplication::applicationDirPath();
 
    QString templateName=ui->reportTypeCombox->currentText();
@@ -395,38 +593,38 @@ void MainWindow::on_generateReportBt_clicked()
        QMessageBox::warning(this, "错误", QString("模板不存在：%1").arg(templateAbsolutePath));
        return;
    }
-   // 2. 设置模板路径和保存路径
-   dimReport.setTemplatePath(templateAbsolutePath);
+   // 2. 设置模板路径
+   job.templatePath = templateAbsolutePath;
 
-   QString timeStr = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
-
-   QString savePath = QDir(appDir).filePath(QString("生成报告/%1_%2.docx").arg(timeStr).arg(templateName));
-   dimReport.setSavePath(savePath);
-
-   // 3. 设置产品参数
-   DimReport::ProductParam prodParam;
-   GetProductParams(&prodParam);
-   dimReport.setProductParam(prodParam);
+   // 3. 设置产品参数和保存路径
+   GetProductParams(&job.product);
 
+   // 文件名带产品序列号；同一秒内重名时由队列再加序号
+   QString timeStr = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
+   QString serialNo = job.product.productSerialNo.trimmed();
+   serialNo.replace(QRegularExpression("[\\\\/:*?\"<>|]"), "_");
+   QString fileName = serialNo.isEmpty() ? QString("%1_%2.docx").arg(timeStr).arg(templateName)
+                                         : QString("%1_%2_%3.docx").arg(timeStr).arg(serialNo).arg(templateName);
+   job.savePath = QDir(appDir).filePath("生成报告/" + fileName);
 
    // 4. 解析CSV参数（直接获取QList，无需转换）
-   QList<DimReport::InspectionParam> paramList = buildParamMapFromCsv();
-   if (paramList.isEmpty()) {
+   job.params = buildParamMapFromCsv();
+   if (job.params.isEmpty()) {
        QMessageBox::warning(this, "警告", "未解析到有效检测参数，无法生成报告！");
        return;
    }
 
-   // 直接遍历QList添加参数（或如果DimReport有批量接口，可直接传递）
-   for (const auto &singleParam : paramList) {
-       dimReport.setInspectParam(singleParam);
-   }
-
-
-   dimReport.GenerateReport();
-
-   // 6. 清空参数（保持不变）
-   dimReport.clearInspectionParams();
+   // 5. 加入后台队列，进度与结果见报告进度条和日志
+   m_reportQueue->enqueue(job);
+}
 
+void MainWindow::on_cancelReportBt_clicked()
+{
+    const int jobId = m_reportQueue->runningJobId();
+    if (jobId != 0 && m_reportQueue->cancel(jobId)) {
+        LOG_INFOF("正在取消报告任务%1……", jobId);
+        ui->cancelReportBt->setEnabled(false);
+    }
 }
 
 
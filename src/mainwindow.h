@@ -4,11 +4,19 @@
 #include <QMainWindow>
 #include <QMap>
 #include <QVariant>
+#include <QTimer>
+#include <QThread>
+#include <QPointer>
 #include"lib/reporttool.h"
+#include"lib/reportqueue.h"
 #include"lib/loadqss.h"
 #include"lib/iconfig.h"
 #include"lib/sqlservice.h"
 #include"lib/ilogger.h"
+#include"lib/productquery.h"
+#include"lib/productcache.h"
+#include"lib/productcatalog.h"
+#include"lib/measurementimport.h"
 //界面
 #include"cell_dbsetting.h"
 
@@ -32,27 +40,62 @@ private slots:
 
     void on_dbsetBt_clicked();
 
-    void on_generateReportBt_clicked();//生成检测报告
+    void on_generateReportBt_clicked();//生成检测报告（加入后台队列）
+
+    void on_cancelReportBt_clicked();//取消正在生成的报告
 
     void on_queryRecordBt_clicked();
 
+    void onJobOrderTextEdited(const QString &text);//工作令号输入（延迟过滤）
+
+    void onJobOrderFilterTimeout();//按输入前缀查询工作令号
+
+    void onJobOrderListScrolled(int value);//工作令号列表滚动（加载下一页）
+
 private:
     Ui::MainWindow *ui;
     //界面+配置
     cell_Dbsetting *dbSetForm;
-    MysqlConfig* mysqlConfig;
 
     // 同步按钮状态与数据库连接状态
     void syncButtonStateWithDbStatus();
     void InitCtrl();
     const QString targetPath = "test_data";
     bool QueryProuductData();
+    bool LoadJobOrderPage(bool reset);//加载一页工作令号（reset为true时从第一页开始）
+    ProductInfo productInfo(const QString &jobOrder);//按需获取完整产品记录
+    void LoadLocalProductCache();//启动时在后台加载本地缓存的产品记录
+    void OnLocalProductCacheLoaded(const ProductLocalCache::LoadResult &result);//本地缓存加载完成（界面线程）
+    void MergeProductRecords(const QList<QVariantMap> &records);//合并产品记录并刷新下拉框
+    void FillJobOrderComboFromCache(const QString &prefix);//按前缀从已加载记录填充下拉框
+    void StartProductDeltaSync();//后台增量同步产品数据
+    void OnProductDeltaSynced(const ProductLocalCache::SyncResult &result);//增量同步完成（界面线程）
+    void StartMeasurementImport();//后台把检测数据CSV导入数据库
+    void InitReportQueue();//报告队列进度/结果显示
+    void UpdateReportStatus(const QString &text);//刷新报告进度条文字与取消按钮
     void  GetProductParams(DimReport::ProductParam*params);
     void LoadCsvFileToUi(const QString &filePath);
     void LoadReportType(const QString &filePath);
     QList<DimReport::InspectionParam> buildParamMapFromCsv();
 private:
-      QMap<QString, QVariantMap> m_jobOrderToRecordMap;
+      ProductCatalog m_productCatalog;               //已加载的完整产品记录（工作令号/序列号哈希索引）
+      static const int JOB_ORDER_PAGE_SIZE = 200;
+      QString m_jobOrderPrefix;                      //当前过滤前缀
+      ProductQuery::PageCursor m_jobOrderCursor;     //下一页游标
+      bool m_jobOrderHasMore = false;
+      QTimer m_jobOrderFilterTimer;                  //输入防抖
+      static const int MAX_COMBO_ITEMS = 2000;       //下拉框最多显示条数
+      bool m_localCacheReady = false;                //本地缓存可用（下拉框由本地数据提供）
+      QPointer<QThread> m_productLoadThread;         //本地缓存加载线程（退出时等待结束）
+      bool m_localCacheLoading = false;              //本地缓存加载中（结果尚未合并）
+      bool m_dbConnecting = false;                   //手动/启动连接进行中，结果出来后输出日志
+      QPointer<QThread> m_productSyncThread;         //进行中的增量同步线程
+      SqlCancelTokenPtr m_productSyncCancel;         //退出时取消进行中的同步查询
+      bool m_productSyncPending = false;             //同步期间又收到同步请求
+      QPointer<QThread> m_measurementImportThread;   //进行中的检测数据导入线程
+      SqlCancelTokenPtr m_measurementImportCancel;   //退出时取消进行中的导入
+      ReportQueue *m_reportQueue = nullptr;          //后台报告生成队列
+      QString m_reportStatusText = "空闲";            //报告进度条显示的当前状态
 
 };
 
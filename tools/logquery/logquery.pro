@@ -0,0 +1,25 @@
+QT       += core
+QT       -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = logquery
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+msvc
+{
+    QMAKE_CFLAGS +=/utf-8
+    QMAKE_CXXFLAGS +=/utf-8
+}
+
+LIBDIR = $$PWD/../../lib
+INCLUDEPATH += $$LIBDIR
+
+HEADERS += \
+    $$LIBDIR/binarylog.h
+
+SOURCES += \
+    $$LIBDIR/binarylog.cpp \
+    $$PWD/main.cpp
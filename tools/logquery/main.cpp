@@ -0,0 +1,112 @@
+﻿///
+/// \brief 结构化日志查询：按时间范围、等级、设备、消息内容筛选.dlog文件，按需渲染为文本
+/// 用法：logquery [--from "2024-01-01 08:00:00"] [--to ...] [--level WARN] [--device SQL]
+///               [--contains JO2024-001] [--limit 1000] <.dlog文件或目录>...
+///
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QTextStream>
+#include "binarylog.h"
+
+static QTextStream& out()
+{
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+static bool parseTime(const QString& text, qint64* msecs)
+{
+    if (text.isEmpty()) return true;
+    QDateTime time = QDateTime::fromString(text, "yyyy-MM-dd hh:mm:ss");
+    if (!time.isValid()) time = QDateTime::fromString(text, "yyyy-MM-dd");
+    if (!time.isValid()) return false;
+    *msecs = time.toMSecsSinceEpoch();
+    return true;
+}
+
+static int parseLevel(const QString& text)
+{
+    for (int level = 0; level < 5; ++level) {
+        if (text.compare(BinaryLog::levelName(level), Qt::CaseInsensitive) == 0) return level;
+    }
+    return -1;
+}
+
+// 参数中的目录展开为其中的.dlog文件（按文件名即时间排序）
+static QStringList collectFiles(const QStringList& paths)
+{
+    QStringList files;
+    for (const QString& path : paths) {
+        QFileInfo info(path);
+        if (info.isDir()) {
+            QDir dir(path);
+            for (const QString& name : dir.entryList(QStringList() << "*" + BinaryLog::dataSuffix(), QDir::Files, QDir::Name)) {
+                files << dir.filePath(name);
+            }
+        } else {
+            files << path;
+        }
+    }
+    return files;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("结构化日志查询");
+    parser.addHelpOption();
+    QCommandLineOption fromOption("from", "开始时间（yyyy-MM-dd[ hh:mm:ss]）", "time");
+    QCommandLineOption toOption("to", "结束时间（yyyy-MM-dd[ hh:mm:ss]）", "time");
+    QCommandLineOption levelOption("level", "最低等级：DEBUG/INFO/WARN/ERROR/FATAL", "level", "DEBUG");
+    QCommandLineOption deviceOption("device", "设备名", "device");
+    QCommandLineOption containsOption("contains", "消息包含的文本（如工作令号）", "text");
+    QCommandLineOption limitOption("limit", "最多输出条数（0不限）", "count", "0");
+    parser.addOptions({fromOption, toOption, levelOption, deviceOption, containsOption, limitOption});
+    parser.addPositionalArgument("paths", ".dlog文件或日志目录");
+    parser.process(app);
+
+    BinaryLogReader::Filter filter;
+    if (!parseTime(parser.value(fromOption), &filter.fromMs) || !parseTime(parser.value(toOption), &filter.toMs)) {
+        out() << "时间格式应为yyyy-MM-dd或yyyy-MM-dd hh:mm:ss" << endl;
+        return 1;
+    }
+    filter.minLevel = parseLevel(parser.value(levelOption));
+    if (filter.minLevel < 0) {
+        out() << "未知等级：" << parser.value(levelOption) << endl;
+        return 1;
+    }
+    filter.device = parser.value(deviceOption);
+    filter.contains = parser.value(containsOption);
+    const int limit = parser.value(limitOption).toInt();
+
+    const QStringList files = collectFiles(parser.positionalArguments());
+    if (files.isEmpty()) {
+        parser.showHelp(1);
+    }
+    int total = 0;
+    bool ok = true;
+    for (const QString& file : files) {
+        BinaryLogReader reader;
+        QString errorMsg;
+        if (!reader.open(file, &errorMsg)) {
+            out() << "打开失败：" << errorMsg << endl;
+            ok = false;
+            continue;
+        }
+        reader.query(filter, [&](const BinaryLogReader::Record& record) {
+            out() << QString("%1 [Device:%2] [%3] [Thread:%4] %5")
+                     .arg(QDateTime::fromMSecsSinceEpoch(record.timestampMs).toString("yyyy-MM-dd hh:mm:ss.zzz"),
+                          record.device.isEmpty() ? "Unknown" : record.device,
+                          BinaryLog::levelName(record.level), record.threadId, record.message) << '\n';
+            ++total;
+            return limit <= 0 || total < limit;
+        });
+        if (limit > 0 && total >= limit) break;
+    }
+    out() << QString("共%1条").arg(total) << endl;
+    return ok ? 0 : 1;
+}
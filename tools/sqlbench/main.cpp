@@ -0,0 +1,125 @@
+﻿///
+/// \brief 产品查询压测：在SQLite/内存库上生成N行测试数据，测量主界面加载产品数据所走的查询路径
+/// 用法：sqlbench [--driver MEMORY|QSQLITE] [--rows 1000,100000,1000000] [--seed 20240101]
+///
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include "iconfig.h"
+#include "sqlservice.h"
+#include "sqlfixture.h"
+#include "productquery.h"
+#include "productcatalog.h"
+
+static QTextStream& out()
+{
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+static void report(const QString& name, qint64 elapsedUs, const QString& detail = QString())
+{
+    out() << QString("  %1 %2 ms  %3").arg(name, -24).arg(elapsedUs / 1000.0, 10, 'f', 2).arg(detail) << endl;
+}
+
+static bool runBenchmark(const QString& driver, int rows, quint32 seed)
+{
+    MysqlConfig config;
+    config.setDriver(driver);
+    config.setDbName(QString("sqlbench_%1").arg(rows));
+    SqlService& sql = SqlService::Get();
+    sql.setConfig(config);
+    if (!sql.connectDb()) {
+        out() << "连接失败：" << sql.lastError() << endl;
+        return false;
+    }
+    out() << QString("== %1 行（%2）==").arg(rows).arg(driver) << endl;
+
+    SqlFixture::Options options;
+    options.productRows = rows;
+    options.seed = seed;
+    QElapsedTimer timer;
+    timer.start();
+    SqlFixture::Result fixture = SqlFixture::generate(options);
+    if (!fixture.success) {
+        out() << "生成测试数据失败：" << fixture.errorMsg << endl;
+        sql.disconnectDb();
+        return false;
+    }
+    report("生成测试数据", timer.nsecsElapsed() / 1000, QString("%1行").arg(fixture.productRows));
+
+    // 在线模式：工作令号首页、前缀过滤、翻页
+    sql.queryCache().clear();
+    timer.restart();
+    ProductQuery::JobOrderPage page = ProductQuery::fetchJobOrderPage(QString(), ProductQuery::PageCursor());
+    report("工作令号首页", timer.nsecsElapsed() / 1000, QString("%1条").arg(page.jobOrders.size()));
+    timer.restart();
+    ProductQuery::fetchJobOrderPage(QString(), ProductQuery::PageCursor());
+    report("工作令号首页（缓存）", timer.nsecsElapsed() / 1000);
+    timer.restart();
+    ProductQuery::fetchJobOrderPage(page.jobOrders.value(0).left(9), page.next);
+    report("前缀过滤翻页", timer.nsecsElapsed() / 1000);
+
+    // 选中工作令号：按需取完整记录
+    const int lookups = 100;
+    timer.restart();
+    for (int i = 0; i < lookups; ++i) {
+        ProductQuery::fetchRecordByJobOrder(SqlFixture::jobOrderNo(int((qint64(i) * 7919) % rows)));
+    }
+    report("按工作令号取记录（均值）", timer.nsecsElapsed() / 1000 / lookups);
+
+    // 本地缓存模式：全量拉取到内存目录，再做前缀搜索
+    ProductCatalog catalog;
+    catalog.reserve(rows);
+    SqlService::DeltaCursor cursor;
+    timer.restart();
+    while (true) {
+        SqlService::QueryResult result = ProductQuery::fetchChangedRecords(cursor, 1000);
+        if (!result.success || result.data.isEmpty()) break;
+        for (const QVariantMap& record : result.data) {
+            catalog.upsert(record);
+        }
+        if (result.data.size() < 1000) break;
+    }
+    report("全量同步到目录", timer.nsecsElapsed() / 1000, QString("%1条").arg(catalog.size()));
+    timer.restart();
+    SqlService::QueryResult delta = ProductQuery::fetchChangedRecords(cursor, 1000);
+    report("增量同步（无变更）", timer.nsecsElapsed() / 1000, QString("%1条").arg(delta.data.size()));
+    timer.restart();
+    QStringList matches = catalog.jobOrdersWithPrefix("JO2024-00", 2000);
+    report("目录前缀搜索", timer.nsecsElapsed() / 1000, QString("%1条").arg(matches.size()));
+    timer.restart();
+    int hits = 0;
+    for (int i = 0; i < lookups; ++i) {
+        hits += catalog.findByJobOrder(SqlFixture::jobOrderNo(int((qint64(i) * 7919) % rows))) ? 1 : 0;
+    }
+    report("目录按工作令号查找（均值）", timer.nsecsElapsed() / 1000 / lookups, QString("命中%1/%2").arg(hits).arg(lookups));
+
+    sql.disconnectDb();
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("产品查询压测（SQLite/内存库）");
+    parser.addHelpOption();
+    QCommandLineOption driverOption("driver", "MEMORY 或 QSQLITE", "driver", BaseMysqlConfig::DRIVER_MEMORY);
+    QCommandLineOption rowsOption("rows", "逗号分隔的行数", "rows", "1000,100000,1000000");
+    QCommandLineOption seedOption("seed", "随机种子", "seed", "20240101");
+    parser.addOptions({driverOption, rowsOption, seedOption});
+    parser.process(app);
+
+    const QString driver = BaseMysqlConfig::normalizeDriver(parser.value(driverOption));
+    if (driver == BaseMysqlConfig::DRIVER_MYSQL) {
+        out() << "压测只支持MEMORY/QSQLITE" << endl;
+        return 1;
+    }
+    bool ok = true;
+    for (const QString& rows : parser.value(rowsOption).split(',', QString::SkipEmptyParts)) {
+        ok = runBenchmark(driver, qMax(1, rows.trimmed().toInt()), parser.value(seedOption).toUInt()) && ok;
+    }
+    return ok ? 0 : 1;
+}
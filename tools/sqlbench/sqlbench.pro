@@ -0,0 +1,43 @@
+QT       += core sql widgets
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = sqlbench
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+msvc
+{
+    QMAKE_CFLAGS +=/utf-8
+    QMAKE_CXXFLAGS +=/utf-8
+}
+
+LIBDIR = $$PWD/../../lib
+INCLUDEPATH += $$LIBDIR
+
+HEADERS += \
+    $$LIBDIR/binarylog.h \
+    $$LIBDIR/iconfig.h \
+    $$LIBDIR/ilogger.h \
+    $$LIBDIR/logarchive.h \
+    $$LIBDIR/logringbuffer.h \
+    $$LIBDIR/productcatalog.h \
+    $$LIBDIR/productquery.h \
+    $$LIBDIR/querycache.h \
+    $$LIBDIR/sqlfixture.h \
+    $$LIBDIR/sqlservice.h \
+    $$LIBDIR/sqlstats.h
+
+SOURCES += \
+    $$LIBDIR/binarylog.cpp \
+    $$LIBDIR/iconfig.cpp \
+    $$LIBDIR/ilogger.cpp \
+    $$LIBDIR/logarchive.cpp \
+    $$LIBDIR/productcatalog.cpp \
+    $$LIBDIR/productquery.cpp \
+    $$LIBDIR/querycache.cpp \
+    $$LIBDIR/sqlfixture.cpp \
+    $$LIBDIR/sqlservice.cpp \
+    $$LIBDIR/sqlstats.cpp \
+    $$PWD/main.cpp